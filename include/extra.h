@@ -1,7 +1,7 @@
 /*
     Project:        Extra Library
     Author:         Aidan Eastcott
-    Last Update:    2022-09-16
+    Last Update:    2026-10-18
     Description:
         A header-only library containing miscellaneous utility macros, functions, and types
 
@@ -11,7 +11,30 @@
         XTR_ALIGNED          Enables xtr::is_aligned function in C++
         XTR_MULTIARRAY       Enables xtr::multiarray type in C++
         XTR_ENUMERATE        Enables xtr::enumerate function in C++
+        XTR_CONCURRENT_MAP   Enables xtr::concurrent_flat_map type in C++
+        XTR_INTRUSIVE        Enables xtr::intrusive_list and xtr::intrusive_hash_set types in C++
+        XTR_CACHE            Enables xtr::lru_cache and xtr::clock_cache types in C++
+        XTR_TIMER_WHEEL      Enables xtr::timer_wheel type in C++, requires XTR_INTRUSIVE
+        XTR_BIT_VECTOR       Enables xtr::bit_vector type in C++
+        XTR_INTEGER_CODEC    Enables xtr::packed_column type and varint functions in C++
+        XTR_HEAP             Enables xtr::dary_heap and xtr::radix_heap types in C++
+        XTR_STABLE_VECTOR    Enables xtr::stable_vector type in C++
+        XTR_FUNCTION         Enables xtr::function_ref and xtr::inplace_function types in C++
+        XTR_PARALLEL         Enables xtr::thread_pool type and parallel algorithms in C++
+        XTR_SORT             Enables xtr::parallel_sort and xtr::kway_merge functions in C++
+        XTR_SEARCH           Enables xtr::argmin, xtr::argmax and xtr::find_index functions in C++
+        XTR_STREAM           Enables xtr::stream_copy and xtr::stream_fill functions in C++
+        XTR_RECORD_READER    Enables xtr::record_reader type in C++ on POSIX systems
+        XTR_COMPRESSION      Enables LZ4 block functions and xtr::compressed_reader type in C++
+        XTR_SERIALIZE        Enables xtr::serialize and xtr::deserialize functions in C++
+        XTR_CHECKSUM         Enables xtr::crc32c functions in C++
+        XTR_TEXT_ENCODING    Enables base64 and hex encoding functions in C++
+        XTR_CSV              Enables xtr::csv_reader type in C++
+        XTR_JSON             Enables xtr::json_parser type in C++
+        XTR_RANDOM           Enables xtr::xoshiro256pp types and bulk random functions in C++
         XTR_NO_CONSTEXPR     Disables use of constexpr specifier in C++
+        XTR_NO_SIMD          Disables code paths specific to instruction set extensions in C++
+        XTR_CACHE_LINE_SIZE  Overrides the cache line size in bytes used for padding in C++
 */
 
 #pragma once
@@ -25,6 +48,94 @@
 #define XTR_ALIGNED
 #define XTR_MULTIARRAY
 #define XTR_ENUMERATE
+#define XTR_CONCURRENT_MAP
+#define XTR_INTRUSIVE
+#define XTR_CACHE
+#define XTR_TIMER_WHEEL
+#define XTR_BIT_VECTOR
+#define XTR_INTEGER_CODEC
+#define XTR_HEAP
+#define XTR_STABLE_VECTOR
+#define XTR_FUNCTION
+#define XTR_PARALLEL
+#define XTR_SORT
+#define XTR_SEARCH
+#define XTR_STREAM
+#define XTR_RECORD_READER
+#define XTR_COMPRESSION
+#define XTR_SERIALIZE
+#define XTR_CHECKSUM
+#define XTR_TEXT_ENCODING
+#define XTR_CSV
+#define XTR_JSON
+#define XTR_RANDOM
+#endif
+
+
+// Enable extra features required by other extra features
+#if defined(XTR_TIMER_WHEEL) && !defined(XTR_INTRUSIVE)
+#define XTR_INTRUSIVE
+#endif
+
+#if defined(XTR_SORT) && !defined(XTR_PARALLEL)
+#define XTR_PARALLEL
+#endif
+
+#if defined(XTR_SEARCH) && !defined(XTR_ENUMERATE)
+#define XTR_ENUMERATE
+#endif
+
+#if defined(XTR_STREAM) && !defined(XTR_ALIGNED)
+#define XTR_ALIGNED
+#endif
+
+#if defined(XTR_CSV) && !defined(XTR_PARALLEL)
+#define XTR_PARALLEL
+#endif
+
+#if defined(XTR_PARALLEL) && !defined(XTR_FUNCTION)
+#define XTR_FUNCTION
+#endif
+
+
+// Enable internal helpers required by extra features
+#if defined(XTR_CONCURRENT_MAP) || defined(XTR_INTRUSIVE) || defined(XTR_CACHE) \
+    || defined(XTR_BIT_VECTOR) || defined(XTR_INTEGER_CODEC) || defined(XTR_HEAP) \
+    || defined(XTR_STABLE_VECTOR) || defined(XTR_PARALLEL) || defined(XTR_SEARCH) \
+    || defined(XTR_CSV) || defined(XTR_JSON)
+#define XTR_DETAIL_BITS
+#endif
+
+
+// Detect instruction set extensions enabled for the target
+#if defined(__cplusplus) && !defined(XTR_NO_SIMD)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XTR_SIMD_SSE2
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define XTR_SIMD_SSSE3
+#endif
+
+#if defined(__SSE4_2__) || defined(__AVX__)
+#define XTR_SIMD_SSE42
+#endif
+
+#if defined(__AVX2__)
+#define XTR_SIMD_AVX2
+#endif
+
+#if defined(__BMI2__)
+#define XTR_SIMD_BMI2
+#endif
+
+#endif
+
+
+// Detect POSIX system interfaces
+#if defined(__cplusplus) && (defined(__unix__) || defined(__APPLE__))
+#define XTR_OS_POSIX
 #endif
 
 
@@ -54,7 +165,9 @@
 #if defined(__cplusplus)
 
 // Shared headers
-#if defined(XTR_ALIGNED)
+#if defined(XTR_ALIGNED) || defined(XTR_DETAIL_BITS) || defined(XTR_CONCURRENT_MAP) \
+    || defined(XTR_PARALLEL) || defined(XTR_COMPRESSION) || defined(XTR_SERIALIZE) \
+    || defined(XTR_CHECKSUM) || defined(XTR_RANDOM)
 #include <cstdint>
 #endif
 
@@ -62,6 +175,10 @@
 // Multiarray headers
 #if defined(XTR_MULTIARRAY)
 #include <array>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 #endif
 
 
@@ -73,8 +190,270 @@
 #endif
 
 
+// Concurrent map headers
+#if defined(XTR_CONCURRENT_MAP)
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <vector>
+#endif
+
+
+// Intrusive container headers
+#if defined(XTR_INTRUSIVE)
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#endif
+
+
+// Cache headers
+#if defined(XTR_CACHE)
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+#endif
+
+
+// Timer wheel headers
+#if defined(XTR_TIMER_WHEEL)
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#endif
+
+
+// Bit vector headers
+#if defined(XTR_BIT_VECTOR)
+#include <iterator>
+#include <vector>
+#endif
+
+
+// Integer codec headers
+#if defined(XTR_INTEGER_CODEC)
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#endif
+
+
+// Heap headers
+#if defined(XTR_HEAP)
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#endif
+
+
+// Stable vector headers
+#if defined(XTR_STABLE_VECTOR)
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#endif
+
+
+// Function wrapper headers
+#if defined(XTR_FUNCTION)
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#endif
+
+
+// Parallel algorithm headers
+#if defined(XTR_PARALLEL)
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#endif
+
+
+// Sort headers
+#if defined(XTR_SORT)
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+#endif
+
+#if defined(XTR_SORT) && defined(XTR_OS_POSIX)
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// Search headers
+#if defined(XTR_SEARCH)
+#include <functional>
+#include <iterator>
+#endif
+
+
+// Stream headers
+#if defined(XTR_STREAM)
+#include <algorithm>
+#include <cstring>
+#endif
+
+
+// Record reader headers
+#if defined(XTR_RECORD_READER) && defined(XTR_OS_POSIX)
+#include <cerrno>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// Compression headers
+#if defined(XTR_COMPRESSION)
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#endif
+
+
+// Serialization headers
+#if defined(XTR_SERIALIZE)
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#endif
+
+
+// Checksum headers
+#if defined(XTR_CHECKSUM)
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#endif
+
+
+// Text encoding headers
+#if defined(XTR_TEXT_ENCODING)
+#include <optional>
+#include <string>
+#include <string_view>
+#endif
+
+
+// CSV headers
+#if defined(XTR_CSV)
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#endif
+
+
+// JSON headers
+#if defined(XTR_JSON)
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#endif
+
+
+// Random headers
+#if defined(XTR_RANDOM)
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#endif
+
+
+// Instruction set extension headers
+#if (defined(XTR_SIMD_BMI2) && defined(XTR_BIT_VECTOR)) \
+    || (defined(XTR_SIMD_SSE2) \
+        && (defined(XTR_INTEGER_CODEC) || defined(XTR_PARALLEL) || defined(XTR_SEARCH) \
+            || defined(XTR_STREAM))) \
+    || (defined(XTR_SIMD_SSE42) && defined(XTR_CHECKSUM)) \
+    || (defined(XTR_SIMD_SSSE3) && defined(XTR_TEXT_ENCODING)) \
+    || (defined(XTR_SIMD_SSE2) && (defined(XTR_CSV) || defined(XTR_JSON) || defined(XTR_RANDOM)))
+#include <immintrin.h>
+#endif
+
+
 // Shared headers
-#if defined(XTR_ALIGNED) || defined(XTR_ENUMERATE)
+#if defined(XTR_ALIGNED) || defined(XTR_MULTIARRAY) || defined(XTR_ENUMERATE) \
+    || defined(XTR_CONCURRENT_MAP) || defined(XTR_INTRUSIVE) || defined(XTR_CACHE) \
+    || defined(XTR_TIMER_WHEEL) || defined(XTR_INTEGER_CODEC) || defined(XTR_HEAP) \
+    || defined(XTR_STABLE_VECTOR) || defined(XTR_PARALLEL) || defined(XTR_SORT) \
+    || defined(XTR_SEARCH) || defined(XTR_STREAM) || defined(XTR_RECORD_READER) \
+    || defined(XTR_COMPRESSION) || defined(XTR_SERIALIZE) || defined(XTR_CHECKSUM) \
+    || defined(XTR_RANDOM) || defined(XTR_FUNCTION)
 #include <type_traits>
 #endif
 
@@ -119,6 +498,12 @@ namespace xtr {}
 #endif
 
 
+// Cache line size used to pad shared data in C++
+#if defined(__cplusplus) && !defined(XTR_CACHE_LINE_SIZE)
+#define XTR_CACHE_LINE_SIZE 64
+#endif
+
+
 // Casting to void
 #if defined(__cplusplus)
 #define XTR_CAST_VOID(expression) static_cast<void>(expression)
@@ -158,7 +543,7 @@ namespace xtr {}
 // Macro to combine assert and assume macros
 #if !defined(assert_assume)
 
-#if defined(NDEBUG)
+#if !defined(NDEBUG)
 #define assert_assume(expression) \
 	do {                          \
 		assert(expression);       \
@@ -217,12 +602,87 @@ namespace xtr {}
 #endif // XTR_LOGGING
 
 
+// Internal bit manipulation helpers in C++
+#if defined(XTR_DETAIL_BITS) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+XTR_NODISCARD inline XTR_CONSTEXPR int popcount(::std::uint64_t value) noexcept {
+#if defined(XTR_COMPILER_GNUC)
+	return __builtin_popcountll(value);
+#else
+	value = value - ((value >> 1) & 0x5555555555555555u);
+	value = (value & 0x3333333333333333u) + ((value >> 2) & 0x3333333333333333u);
+	value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Fu;
+	return static_cast<int>((value * 0x0101010101010101u) >> 56);
+#endif
+}
+
+// The result is undefined when value is zero
+XTR_NODISCARD inline XTR_CONSTEXPR int countr_zero(::std::uint64_t value) noexcept {
+#if defined(XTR_COMPILER_GNUC)
+	return __builtin_ctzll(value);
+#else
+	return popcount((value & (~value + 1)) - 1);
+#endif
+}
+
+XTR_NODISCARD inline XTR_CONSTEXPR int countl_zero(::std::uint64_t value) noexcept {
+#if defined(XTR_COMPILER_GNUC)
+	return value == 0 ? 64 : __builtin_clzll(value);
+#else
+	int result = 0;
+	for (int shift = 32; shift > 0; shift /= 2) {
+		if ((value >> (64 - shift - result)) == 0) {
+			result += shift;
+		}
+	}
+	return value == 0 ? 64 : result;
+#endif
+}
+
+XTR_NODISCARD inline XTR_CONSTEXPR int bit_width(::std::uint64_t value) noexcept {
+	return 64 - countl_zero(value);
+}
+
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::size_t bit_ceil(::std::size_t value) noexcept {
+	return value <= 1 ? 1 : ::std::size_t{1} << bit_width(value - 1);
+}
+
+// Bit i is set when an odd number of bits up to and including i are set, so given the positions
+// of quotes it marks the bytes inside quoted text
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::uint64_t prefix_xor(::std::uint64_t bits) noexcept {
+	for (int shift = 1; shift < 64; shift *= 2) {
+		bits ^= bits << shift;
+	}
+	return bits;
+}
+
+// Finalizer from MurmurHash3 to spread weak hashes such as std::hash over all bits
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::uint64_t mix_hash(::std::uint64_t value) noexcept {
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDu;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53u;
+	value ^= value >> 33;
+	return value;
+}
+
+} // namespace detail
+
+} // namespace xtr
+
+#endif // XTR_DETAIL_BITS
+
+
 // Memory alignment check in C++
 #if defined(XTR_ALIGNED) && defined(__cplusplus)
 
 namespace xtr {
 
-XTR_NODISCARD bool is_aligned(const void *pointer, ::std::size_t alignment) noexcept {
+XTR_NODISCARD inline bool is_aligned(const void *pointer, ::std::size_t alignment) noexcept {
 	using comparison_type =
 	    typename ::std::conditional<(sizeof(::std::uintptr_t) > sizeof(::std::size_t)),
 	                                ::std::uintptr_t, ::std::size_t>::type;
@@ -267,6 +727,78 @@ struct multiarray_base<Type, I> {
 template <typename Type, ::std::size_t I, ::std::size_t... J>
 using multiarray = typename detail::multiarray_base<Type, I, J...>::type;
 
+
+// Element access that asserts every index is in bounds in debug builds and lets the optimizer
+// assume it in release builds, without the per dimension checks of hardened operator[]
+template <typename Array>
+XTR_NODISCARD XTR_CONSTEXPR Array &at_assumed(Array &array) noexcept {
+	return array;
+}
+
+template <typename Array, typename Index, typename... Indices>
+XTR_NODISCARD XTR_CONSTEXPR decltype(auto) at_assumed(Array &array, Index index,
+                                                      Indices... indices) noexcept {
+	static_assert(::std::is_integral_v<Index>, "Index must be an integer");
+	assert_assume(static_cast<::std::size_t>(index) < ::std::size(array));
+	return at_assumed(::std::data(array)[index], indices...);
+}
+
+
+// Allocator adaptor that default-initializes instead of value-initializing, so containers of
+// trivial types such as multiarray leave new elements unwritten instead of zeroing them
+template <typename Type, typename Allocator = ::std::allocator<Type>>
+class default_init_allocator : public Allocator {
+	using traits = ::std::allocator_traits<Allocator>;
+
+public:
+	template <typename Other>
+	struct rebind {
+		using other =
+		    default_init_allocator<Other, typename traits::template rebind_alloc<Other>>;
+	};
+
+	using Allocator::Allocator;
+
+	default_init_allocator() = default;
+
+	template <typename Other, typename OtherAllocator>
+	default_init_allocator(const default_init_allocator<Other, OtherAllocator> &other) noexcept :
+	    Allocator{static_cast<const OtherAllocator &>(other)} {}
+
+
+	template <typename Other>
+	void construct(Other *pointer) noexcept(::std::is_nothrow_default_constructible_v<Other>) {
+		::new (static_cast<void *>(pointer)) Other;
+	}
+
+	template <typename Other, typename... Parameters>
+	void construct(Other *pointer, Parameters &&...parameters) {
+		traits::construct(static_cast<Allocator &>(*this), pointer,
+		                  ::std::forward<Parameters>(parameters)...);
+	}
+};
+
+
+// Vector of multiarrays whose resize leaves trivial elements uninitialized
+template <typename Type, ::std::size_t I, ::std::size_t... J>
+using multiarray_vector =
+    ::std::vector<multiarray<Type, I, J...>, default_init_allocator<multiarray<Type, I, J...>>>;
+
+
+// Same as std::make_unique but default-initializes, matching the C++20 function of the same name
+template <typename Type>
+XTR_NODISCARD ::std::enable_if_t<!::std::is_array_v<Type>, ::std::unique_ptr<Type>>
+make_unique_for_overwrite() {
+	return ::std::unique_ptr<Type>{new Type};
+}
+
+template <typename Type>
+XTR_NODISCARD ::std::enable_if_t<::std::is_array_v<Type> && ::std::extent_v<Type> == 0,
+                                 ::std::unique_ptr<Type>>
+make_unique_for_overwrite(::std::size_t count) {
+	return ::std::unique_ptr<Type>{new ::std::remove_extent_t<Type>[count]};
+}
+
 } // namespace xtr
 
 #endif // XTR_MULTIARRAY
@@ -377,7 +909,22 @@ struct indexed_iterator_base {
 	}
 };
 
+// Contiguous iterators are recognized by concept in C++20 and only pointers are assumed before
+template <typename Iterator>
+inline constexpr bool is_contiguous_iterator_v =
+#if defined(__cpp_lib_concepts)
+    ::std::contiguous_iterator<Iterator>;
+#else
+    ::std::is_pointer_v<Iterator>;
+#endif
+
 template <typename Iterator, typename Index>
+using is_index_from_distance =
+    ::std::bool_constant<is_contiguous_iterator_v<::std::remove_reference_t<Iterator>>
+                         && ::std::is_integral_v<Index>>;
+
+template <typename Iterator, typename Index,
+          bool IndexFromDistance = is_index_from_distance<Iterator, Index>::value>
 struct indexed_iterator : indexed_iterator_base<Iterator> {
 
 	using iterator_type = typename indexed_iterator_base<Iterator>::iterator_type;
@@ -427,6 +974,53 @@ struct indexed_iterator : indexed_iterator_base<Iterator> {
 	}
 };
 
+// Derives the index from the distance to the first element instead of incrementing a counter
+// alongside the iterator, which frees a register in the loop
+template <typename Iterator, typename Index>
+struct indexed_iterator<Iterator, Index, true> : indexed_iterator_base<Iterator> {
+
+	using iterator_type = typename indexed_iterator_base<Iterator>::iterator_type;
+	using index_type = Index;
+
+	::std::remove_reference_t<iterator_type> m_first;
+
+
+	using is_constructor_noexcept = ::std::conjunction<
+	    ::std::is_nothrow_copy_constructible<::std::remove_reference_t<iterator_type>>,
+	    ::std::is_nothrow_constructible<indexed_iterator_base<Iterator>,
+	                                    ::std::add_rvalue_reference_t<iterator_type>>>;
+
+	XTR_CONSTEXPR
+	indexed_iterator(iterator_type iterator) noexcept(is_constructor_noexcept::value) :
+	    indexed_iterator_base<Iterator>{::std::forward<iterator_type>(iterator)},
+	    m_first{indexed_iterator_base<Iterator>::m_iterator} {}
+
+
+	using is_increment_noexcept = ::std::bool_constant<noexcept(
+	    ++::std::declval<::std::add_lvalue_reference_t<iterator_type>>())>;
+
+	XTR_CONSTEXPR void operator++() noexcept(is_increment_noexcept::value) {
+		++indexed_iterator_base<Iterator>::m_iterator;
+	}
+
+
+	using dereference_result_type =
+	    ::std::tuple<::std::add_const_t<index_type>,
+	                 decltype(*::std::declval<::std::add_lvalue_reference_t<iterator_type>>())>;
+
+	using is_dereference_noexcept = ::std::conjunction<
+	    ::std::bool_constant<noexcept(
+	        *::std::declval<::std::add_lvalue_reference_t<iterator_type>>())>,
+	    ::std::is_nothrow_constructible<
+	        dereference_result_type, index_type,
+	        decltype(*::std::declval<::std::add_lvalue_reference_t<iterator_type>>())>>;
+
+	XTR_CONSTEXPR dereference_result_type operator*() noexcept(is_dereference_noexcept::value) {
+		const auto &iterator = indexed_iterator_base<Iterator>::m_iterator;
+		return {static_cast<index_type>(iterator - m_first), *iterator};
+	}
+};
+
 
 using ::std::begin;
 using ::std::end;
@@ -517,4 +1111,9242 @@ XTR_NODISCARD
 #endif // XTR_ENUMERATE
 
 
+// Concurrent hash map with lock-free reads in C++
+#if defined(XTR_CONCURRENT_MAP) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+template <typename Type>
+inline constexpr ::std::size_t word_count_v =
+    (sizeof(Type) + sizeof(::std::uint64_t) - 1) / sizeof(::std::uint64_t);
+
+// Objects are copied through relaxed atomic words so that racing reads are well defined
+template <typename Type>
+void store_words(::std::atomic<::std::uint64_t> *words, const Type &value) noexcept {
+	::std::uint64_t buffer[word_count_v<Type>] = {};
+	::std::memcpy(buffer, ::std::addressof(value), sizeof(Type));
+	for (::std::size_t i = 0; i < word_count_v<Type>; ++i) {
+		words[i].store(buffer[i], ::std::memory_order_relaxed);
+	}
+}
+
+template <typename Type>
+void load_words(const ::std::atomic<::std::uint64_t> *words, void *target) noexcept {
+	::std::uint64_t buffer[word_count_v<Type>];
+	for (::std::size_t i = 0; i < word_count_v<Type>; ++i) {
+		buffer[i] = words[i].load(::std::memory_order_relaxed);
+	}
+	::std::memcpy(target, buffer, sizeof(Type));
+}
+
+// Loads through raw storage, so types need not be default constructible
+template <typename Type>
+XTR_NODISCARD Type load_words(const ::std::atomic<::std::uint64_t> *words) noexcept {
+	alignas(Type) unsigned char storage[sizeof(Type)];
+	load_words<Type>(words, storage);
+	return *::std::launder(reinterpret_cast<Type *>(storage));
+}
+
+enum class concurrent_slot_state : ::std::uint32_t { empty, full, deleted, moved };
+
+// A bucket protected by its own sequence lock, odd sequence values mark a write in progress
+template <typename Key, typename Value>
+struct concurrent_map_slot {
+
+	::std::atomic<::std::uint32_t> m_sequence;
+	::std::atomic<concurrent_slot_state> m_state;
+	::std::atomic<::std::uint64_t> m_key[word_count_v<Key>];
+	::std::atomic<::std::uint64_t> m_value[word_count_v<Value>];
+
+
+	void write(concurrent_slot_state state, const Key *key, const Value *value) noexcept {
+		const auto sequence = m_sequence.load(::std::memory_order_relaxed);
+		m_sequence.store(sequence + 1, ::std::memory_order_relaxed);
+		::std::atomic_thread_fence(::std::memory_order_release);
+		m_state.store(state, ::std::memory_order_relaxed);
+		if (key != nullptr) {
+			store_words(m_key, *key);
+		}
+		if (value != nullptr) {
+			store_words(m_value, *value);
+		}
+		m_sequence.store(sequence + 2, ::std::memory_order_release);
+	}
+};
+
+template <typename Key, typename Value>
+struct concurrent_map_table {
+
+	using slot_type = concurrent_map_slot<Key, Value>;
+
+	::std::size_t m_mask;
+	::std::size_t m_used; // Full and deleted slots, only accessed by writers
+	::std::unique_ptr<slot_type[]> m_slots;
+
+
+	explicit concurrent_map_table(::std::size_t capacity) :
+	    m_mask{capacity - 1}, m_used{0}, m_slots{new slot_type[capacity]()} {}
+
+
+	XTR_NODISCARD ::std::size_t capacity() const noexcept {
+		return m_mask + 1;
+	}
+
+
+	// Lock-free lookup that copies the value to raw storage unless it is null, returns false
+	// once an empty slot ends the probe sequence. The value is staged locally and only copied
+	// out once the sequence check passes, so a miss leaves the storage untouched
+	template <typename KeyEqual>
+	bool find(::std::size_t hash, const Key &key, const KeyEqual &equal, void *value) const {
+		alignas(Value) unsigned char staged[sizeof(Value)];
+		for (::std::size_t i = hash & m_mask, probes = 0; probes <= m_mask;
+		     i = (i + 1) & m_mask, ++probes) {
+			const slot_type &slot = m_slots[i];
+			for (;;) {
+				const auto sequence = slot.m_sequence.load(::std::memory_order_acquire);
+				if ((sequence & 1) != 0) {
+					continue;
+				}
+				const auto state = slot.m_state.load(::std::memory_order_relaxed);
+				bool match = false;
+				if (state == concurrent_slot_state::full) {
+					match = equal(load_words<Key>(slot.m_key), key);
+					if (match && value != nullptr) {
+						load_words<Value>(slot.m_value, staged);
+					}
+				}
+				::std::atomic_thread_fence(::std::memory_order_acquire);
+				if (slot.m_sequence.load(::std::memory_order_relaxed) != sequence) {
+					continue;
+				}
+				if (state == concurrent_slot_state::empty) {
+					return false;
+				}
+				if (match) {
+					if (value != nullptr) {
+						::std::memcpy(value, staged, sizeof(Value));
+					}
+					return true;
+				}
+				break;
+			}
+		}
+		return false;
+	}
+
+
+	static constexpr ::std::size_t npos = static_cast<::std::size_t>(-1);
+
+	// Lookup for writers holding the segment lock, also reports the first reusable slot
+	template <typename KeyEqual>
+	::std::size_t find_locked(::std::size_t hash, const Key &key, const KeyEqual &equal,
+	                          ::std::size_t *free_slot = nullptr) const {
+		::std::size_t reusable = npos;
+		for (::std::size_t i = hash & m_mask, probes = 0; probes <= m_mask;
+		     i = (i + 1) & m_mask, ++probes) {
+			const slot_type &slot = m_slots[i];
+			const auto state = slot.m_state.load(::std::memory_order_relaxed);
+			if (state == concurrent_slot_state::empty) {
+				if (reusable == npos) {
+					reusable = i;
+				}
+				break;
+			}
+			if (state == concurrent_slot_state::full) {
+				if (equal(load_words<Key>(slot.m_key), key)) {
+					return i;
+				}
+			}
+			else if (reusable == npos) {
+				reusable = i;
+			}
+		}
+		if (free_slot != nullptr) {
+			*free_slot = reusable;
+		}
+		return npos;
+	}
+};
+
+template <typename Key, typename Value>
+struct concurrent_map_state {
+	concurrent_map_table<Key, Value> *m_current;
+	concurrent_map_table<Key, Value> *m_previous; // Table being migrated, if any
+};
+
+// Slot a thread tries first when it pins an epoch, spreads threads over the reader slots
+XTR_NODISCARD inline ::std::size_t concurrent_reader_hint() noexcept {
+	static ::std::atomic<::std::size_t> next{0};
+	static thread_local const ::std::size_t hint = next.fetch_add(1, ::std::memory_order_relaxed);
+	return hint;
+}
+
+// Epoch based reclamation for lock-free readers, each reader pins the current epoch in a slot
+// of its own cache line, and objects retired in an epoch are freed once no pin is that old
+class concurrent_map_readers {
+	struct alignas(XTR_CACHE_LINE_SIZE) slot {
+		::std::atomic<::std::uint64_t> m_epoch{0}; // Zero when no reader holds the slot
+	};
+
+	::std::atomic<::std::uint64_t> m_epoch{1};
+	::std::size_t m_mask;
+	::std::unique_ptr<slot[]> m_slots;
+
+public:
+	class guard {
+		::std::atomic<::std::uint64_t> *m_slot;
+
+	public:
+		explicit guard(concurrent_map_readers &readers) noexcept : m_slot{readers.pin()} {}
+
+		guard(const guard &) = delete;
+		guard &operator=(const guard &) = delete;
+
+		~guard() {
+			m_slot->store(0, ::std::memory_order_release);
+		}
+	};
+
+
+	concurrent_map_readers() :
+	    m_mask{bit_ceil(2 * ::std::max(::std::thread::hardware_concurrency(), 1u)) - 1},
+	    m_slots{new slot[m_mask + 1]} {}
+
+
+	// Called by writers after unpublishing objects, returns the epoch to tag them with
+	::std::uint64_t retire() noexcept {
+		return m_epoch.fetch_add(1, ::std::memory_order_seq_cst);
+	}
+
+	// Objects tagged with an epoch below this are no longer reachable by any reader
+	XTR_NODISCARD ::std::uint64_t oldest() const noexcept {
+		auto result = static_cast<::std::uint64_t>(-1);
+		for (::std::size_t i = 0; i <= m_mask; ++i) {
+			const auto epoch = m_slots[i].m_epoch.load(::std::memory_order_seq_cst);
+			if (epoch != 0 && epoch < result) {
+				result = epoch;
+			}
+		}
+		return result;
+	}
+
+private:
+	::std::atomic<::std::uint64_t> *pin() noexcept {
+		for (auto i = concurrent_reader_hint();; ++i) {
+			auto &epoch = m_slots[i & m_mask].m_epoch;
+			::std::uint64_t expected = 0;
+			if (epoch.load(::std::memory_order_relaxed) == 0
+			    && epoch.compare_exchange_strong(expected,
+			                                     m_epoch.load(::std::memory_order_acquire),
+			                                     ::std::memory_order_seq_cst)) {
+				return &epoch;
+			}
+			if ((i & m_mask) == m_mask) {
+				::std::this_thread::yield();
+			}
+		}
+	}
+};
+
+template <typename Key, typename Value>
+struct alignas(XTR_CACHE_LINE_SIZE) concurrent_map_segment {
+
+	using table_type = concurrent_map_table<Key, Value>;
+	using state_type = concurrent_map_state<Key, Value>;
+
+	template <typename Type>
+	struct retired {
+		::std::uint64_t m_epoch;
+		::std::unique_ptr<Type> m_object;
+	};
+
+	::std::atomic<const state_type *> m_state{nullptr};
+	::std::atomic<::std::size_t> m_size{0};
+	::std::mutex m_mutex;
+	::std::size_t m_migrated{0};
+	concurrent_map_readers *m_readers{nullptr};
+
+	// Published objects, and unpublished ones tagged with the epoch they were retired in
+	::std::unique_ptr<state_type> m_published;
+	::std::unique_ptr<table_type> m_current;
+	::std::unique_ptr<table_type> m_previous;
+	::std::vector<retired<state_type>> m_retired_states;
+	::std::vector<retired<table_type>> m_retired_tables;
+	::std::unique_ptr<table_type> m_spare; // Reclaimed table reused by a resize of equal size
+
+
+	void initialize(::std::size_t capacity, concurrent_map_readers &readers) {
+		m_readers = &readers;
+		m_current = ::std::make_unique<table_type>(capacity);
+		publish();
+	}
+
+	XTR_NODISCARD const state_type *load_state() const noexcept {
+		return m_state.load(::std::memory_order_seq_cst);
+	}
+
+	// Makes a new table current and keeps the old one readable until it has been migrated
+	table_type *start_resize(::std::size_t capacity) {
+		assert(m_previous == nullptr);
+		::std::unique_ptr<table_type> table;
+		if (m_spare != nullptr && m_spare->capacity() == capacity) {
+			table = ::std::move(m_spare);
+			for (::std::size_t i = 0; i < capacity; ++i) {
+				table->m_slots[i].m_state.store(concurrent_slot_state::empty,
+				                                ::std::memory_order_relaxed);
+			}
+			table->m_used = 0;
+		}
+		else {
+			m_spare.reset();
+			table = ::std::make_unique<table_type>(capacity);
+		}
+		m_previous = ::std::move(m_current);
+		m_current = ::std::move(table);
+		m_migrated = 0;
+		publish();
+		return m_current.get();
+	}
+
+	void finish_resize() {
+		auto previous = ::std::move(m_previous);
+		publish();
+		m_retired_tables.push_back({m_readers->retire(), ::std::move(previous)});
+		reclaim();
+	}
+
+	// Writers free what readers have left behind, so a reader that was preempted while pinned
+	// delays reclamation only until the next write
+	void collect() {
+		if (!m_retired_states.empty() || !m_retired_tables.empty()) {
+			reclaim();
+		}
+	}
+
+private:
+	void publish() {
+		auto state = ::std::make_unique<state_type>(state_type{m_current.get(), m_previous.get()});
+		m_state.store(state.get(), ::std::memory_order_seq_cst);
+		if (m_published != nullptr) {
+			m_retired_states.push_back({m_readers->retire(), ::std::move(m_published)});
+		}
+		m_published = ::std::move(state);
+		reclaim();
+	}
+
+	void reclaim() {
+		const auto oldest = m_readers->oldest();
+		const auto expired = [oldest](const auto &entry) { return entry.m_epoch < oldest; };
+		for (auto &entry : m_retired_tables) {
+			if (expired(entry) && entry.m_object->capacity() == m_current->capacity()) {
+				m_spare = ::std::move(entry.m_object);
+			}
+		}
+		m_retired_tables.erase(::std::remove_if(m_retired_tables.begin(), m_retired_tables.end(),
+		                                        expired),
+		                       m_retired_tables.end());
+		m_retired_states.erase(::std::remove_if(m_retired_states.begin(), m_retired_states.end(),
+		                                        expired),
+		                       m_retired_states.end());
+	}
+};
+
+} // namespace detail
+
+
+// Hash map with lock-free reads, striped writer locks, and incremental resizing
+template <typename Key, typename Value, typename Hash = ::std::hash<Key>,
+          typename KeyEqual = ::std::equal_to<Key>>
+class concurrent_flat_map {
+public:
+	using key_type = Key;
+	using mapped_type = Value;
+	using size_type = ::std::size_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+
+	static_assert(::std::is_trivially_copyable_v<key_type>, "key_type must be trivially copyable");
+	static_assert(::std::is_trivially_copyable_v<mapped_type>,
+	              "mapped_type must be trivially copyable");
+
+private:
+	using segment_type = detail::concurrent_map_segment<key_type, mapped_type>;
+	using table_type = typename segment_type::table_type;
+	using slot_state = detail::concurrent_slot_state;
+
+	static constexpr size_type minimum_capacity = 8;
+	static constexpr size_type migration_batch = 32;
+
+	mutable detail::concurrent_map_readers m_readers;
+	::std::unique_ptr<segment_type[]> m_segments;
+	size_type m_segment_mask;
+	int m_segment_bits;
+	hasher m_hash;
+	key_equal m_equal;
+
+public:
+	explicit concurrent_flat_map(size_type capacity = 0, size_type stripes = 64,
+	                             const hasher &hash = hasher{},
+	                             const key_equal &equal = key_equal{}) :
+	    m_segments{}, m_segment_mask{detail::bit_ceil(stripes) - 1},
+	    m_segment_bits{detail::bit_width(m_segment_mask)}, m_hash{hash}, m_equal{equal} {
+		m_segments.reset(new segment_type[m_segment_mask + 1]);
+		const size_type segment_capacity =
+		    detail::bit_ceil(capacity / (m_segment_mask + 1) * 4 / 3 + 1);
+		for (size_type i = 0; i <= m_segment_mask; ++i) {
+			m_segments[i].initialize(::std::max(segment_capacity, minimum_capacity), m_readers);
+		}
+	}
+
+	concurrent_flat_map(const concurrent_flat_map &) = delete;
+	concurrent_flat_map &operator=(const concurrent_flat_map &) = delete;
+
+
+	// Never blocks, the returned value is a snapshot taken without any lock
+	XTR_NODISCARD ::std::optional<mapped_type> find(const key_type &key) const {
+		alignas(mapped_type) unsigned char storage[sizeof(mapped_type)];
+		if (find_into(key, storage)) {
+			return *::std::launder(reinterpret_cast<mapped_type *>(storage));
+		}
+		return ::std::nullopt;
+	}
+
+	bool find(const key_type &key, mapped_type &value) const {
+		return find_into(key, ::std::addressof(value));
+	}
+
+	XTR_NODISCARD bool contains(const key_type &key) const {
+		return find_into(key, nullptr);
+	}
+
+
+
+	// Returns true if the key was inserted, or false if it already existed
+	bool insert(const key_type &key, const mapped_type &value) {
+		return emplace(key, value, false);
+	}
+
+	// Returns true if the key was inserted, or false if an existing value was assigned
+	bool insert_or_assign(const key_type &key, const mapped_type &value) {
+		return emplace(key, value, true);
+	}
+
+	// Returns true if the key was erased
+	bool erase(const key_type &key) {
+		const auto [segment, hash] = locate(key);
+		const ::std::lock_guard<::std::mutex> lock{segment->m_mutex};
+		segment->collect();
+		migrate(*segment, migration_batch);
+		const auto *state = segment->m_state.load(::std::memory_order_relaxed);
+		for (table_type *table : {state->m_previous, state->m_current}) {
+			if (table == nullptr) {
+				continue;
+			}
+			const auto index = table->find_locked(hash, key, m_equal);
+			if (index != table_type::npos) {
+				table->m_slots[index].write(slot_state::deleted, nullptr, nullptr);
+				segment->m_size.fetch_sub(1, ::std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void clear() {
+		for (size_type i = 0; i <= m_segment_mask; ++i) {
+			segment_type &segment = m_segments[i];
+			const ::std::lock_guard<::std::mutex> lock{segment.m_mutex};
+			migrate(segment, static_cast<size_type>(-1));
+			table_type &table = *segment.m_state.load(::std::memory_order_relaxed)->m_current;
+			for (size_type j = 0; j < table.capacity(); ++j) {
+				if (table.m_slots[j].m_state.load(::std::memory_order_relaxed)
+				    != slot_state::empty) {
+					table.m_slots[j].write(slot_state::empty, nullptr, nullptr);
+				}
+			}
+			table.m_used = 0;
+			segment.m_size.store(0, ::std::memory_order_relaxed);
+		}
+	}
+
+
+	// Approximate while writers are active
+	XTR_NODISCARD size_type size() const noexcept {
+		size_type result = 0;
+		for (size_type i = 0; i <= m_segment_mask; ++i) {
+			result += m_segments[i].m_size.load(::std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return size() == 0;
+	}
+
+private:
+	::std::pair<segment_type *, size_type> locate(const key_type &key) const {
+		const auto hash = detail::mix_hash(static_cast<::std::uint64_t>(m_hash(key)));
+		return {&m_segments[hash & m_segment_mask], static_cast<size_type>(hash >> m_segment_bits)};
+	}
+
+	bool find_into(const key_type &key, void *value) const {
+		const auto [segment, hash] = locate(key);
+		const detail::concurrent_map_readers::guard guard{m_readers};
+		const auto *state = segment->load_state();
+		for (;;) {
+			// The previous table must be searched first, entries move from it to the current one
+			const auto *previous = state->m_previous;
+			if (previous != nullptr && previous->find(hash, key, m_equal, value)) {
+				return true;
+			}
+			if (state->m_current->find(hash, key, m_equal, value)) {
+				return true;
+			}
+			const auto *latest = segment->load_state();
+			if (latest == state) {
+				return false;
+			}
+			state = latest;
+		}
+	}
+
+	bool emplace(const key_type &key, const mapped_type &value, bool assign) {
+		const auto [segment, hash] = locate(key);
+		const ::std::lock_guard<::std::mutex> lock{segment->m_mutex};
+		segment->collect();
+		migrate(*segment, migration_batch);
+		const auto *state = segment->m_state.load(::std::memory_order_relaxed);
+
+		// Keys are never live in both tables, so an old entry is moved before it is modified
+		if (state->m_previous != nullptr) {
+			const auto index = state->m_previous->find_locked(hash, key, m_equal);
+			if (index != table_type::npos) {
+				move_slot(*state->m_previous, index, *state->m_current, hash);
+			}
+		}
+
+		size_type free_slot = table_type::npos;
+		const auto index = state->m_current->find_locked(hash, key, m_equal, &free_slot);
+		if (index != table_type::npos) {
+			if (assign) {
+				state->m_current->m_slots[index].write(slot_state::full, &key, &value);
+			}
+			return false;
+		}
+
+		table_type *table = state->m_current;
+		if ((table->m_used + 1) * 4 > table->capacity() * 3) {
+			table = grow(*segment);
+			table->find_locked(hash, key, m_equal, &free_slot);
+		}
+		auto &slot = table->m_slots[free_slot];
+		if (slot.m_state.load(::std::memory_order_relaxed) == slot_state::empty) {
+			++table->m_used;
+		}
+		slot.write(slot_state::full, &key, &value);
+		segment->m_size.fetch_add(1, ::std::memory_order_relaxed);
+		return true;
+	}
+
+	void move_slot(table_type &source, size_type index, table_type &target, size_type hash) {
+		auto &slot = source.m_slots[index];
+		const auto key = detail::load_words<key_type>(slot.m_key);
+		const auto value = detail::load_words<mapped_type>(slot.m_value);
+		size_type free_slot = table_type::npos;
+		target.find_locked(hash, key, m_equal, &free_slot);
+		auto &target_slot = target.m_slots[free_slot];
+		if (target_slot.m_state.load(::std::memory_order_relaxed) == slot_state::empty) {
+			++target.m_used;
+		}
+		// Publish into the new table before hiding the old entry from readers
+		target_slot.write(slot_state::full, &key, &value);
+		slot.write(slot_state::moved, nullptr, nullptr);
+	}
+
+	// Moves up to count slots of the previous table, finishing the resize when none remain
+	void migrate(segment_type &segment, size_type count) {
+		const auto *state = segment.m_state.load(::std::memory_order_relaxed);
+		table_type *previous = state->m_previous;
+		if (previous == nullptr) {
+			return;
+		}
+		for (; count > 0 && segment.m_migrated < previous->capacity(); --count) {
+			const auto index = segment.m_migrated++;
+			auto &slot = previous->m_slots[index];
+			if (slot.m_state.load(::std::memory_order_relaxed) == slot_state::full) {
+				const auto key = detail::load_words<key_type>(slot.m_key);
+				const auto hash = detail::mix_hash(static_cast<::std::uint64_t>(m_hash(key)));
+				move_slot(*previous, index, *state->m_current,
+				          static_cast<size_type>(hash >> m_segment_bits));
+			}
+		}
+		if (segment.m_migrated == previous->capacity()) {
+			segment.finish_resize();
+		}
+	}
+
+	// Starts an incremental resize of a single segment, leaving every other segment untouched,
+	// a resize that only clears deleted slots reuses the table retired by the previous one
+	table_type *grow(segment_type &segment) {
+		migrate(segment, static_cast<size_type>(-1));
+		table_type *current = segment.m_state.load(::std::memory_order_relaxed)->m_current;
+		const auto live = segment.m_size.load(::std::memory_order_relaxed) + 1;
+		auto capacity = current->capacity();
+		while (live * 8 > capacity * 3) {
+			capacity *= 2;
+		}
+		return segment.start_resize(capacity);
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_CONCURRENT_MAP
+
+
+// Intrusive containers linking objects through a member hook in C++
+#if defined(XTR_INTRUSIVE) && defined(__cplusplus)
+
+namespace xtr {
+
+// Member that allows an object to be linked into an intrusive container without allocation
+struct intrusive_hook {
+
+	intrusive_hook *m_next = nullptr;
+	intrusive_hook *m_previous = nullptr;
+
+
+	intrusive_hook() noexcept = default;
+
+	// Copying an object must not copy its membership of a container
+	intrusive_hook(const intrusive_hook &) noexcept {}
+
+	intrusive_hook &operator=(const intrusive_hook &) noexcept {
+		return *this;
+	}
+
+
+	XTR_NODISCARD bool is_linked() const noexcept {
+		return m_next != nullptr;
+	}
+};
+
+namespace detail {
+
+// Debug builds catch an object being inserted while it is still linked elsewhere
+inline void intrusive_link_before(intrusive_hook *position, intrusive_hook *node) noexcept {
+	assert(!node->is_linked() && "object is already linked into an intrusive container");
+	node->m_next = position;
+	node->m_previous = position->m_previous;
+	position->m_previous->m_next = node;
+	position->m_previous = node;
+}
+
+inline void intrusive_unlink(intrusive_hook *node) noexcept {
+	node->m_previous->m_next = node->m_next;
+	node->m_next->m_previous = node->m_previous;
+	node->m_next = nullptr;
+	node->m_previous = nullptr;
+}
+
+inline void intrusive_reset(intrusive_hook *sentinel) noexcept {
+	sentinel->m_next = sentinel;
+	sentinel->m_previous = sentinel;
+}
+
+template <typename>
+struct member_pointer_traits {};
+
+template <typename Type, typename Member>
+struct member_pointer_traits<Member Type::*> {
+	using class_type = Type;
+	using member_type = Member;
+};
+
+// Hooks may be any type derived from intrusive_hook so that they can carry extra state
+template <typename Type, auto Hook>
+using is_intrusive_hook = ::std::conjunction<
+    ::std::is_same<Type, typename member_pointer_traits<decltype(Hook)>::class_type>,
+    ::std::is_base_of<intrusive_hook, typename member_pointer_traits<decltype(Hook)>::member_type>>;
+
+// Byte offset of the hook in Type, read from the member pointer because both the Itanium and
+// Microsoft ABIs represent a data member pointer as the offset of the member, which needs no
+// object to exist and folds to a constant
+template <auto Hook>
+XTR_NODISCARD ::std::ptrdiff_t intrusive_hook_offset() noexcept {
+	using offset_type = ::std::conditional_t<sizeof(Hook) == 4, ::std::int32_t, ::std::int64_t>;
+	static_assert(sizeof(Hook) == sizeof(offset_type), "unsupported member pointer layout");
+	const auto hook = Hook;
+	offset_type offset;
+	::std::memcpy(&offset, &hook, sizeof(offset));
+	return static_cast<::std::ptrdiff_t>(offset);
+}
+
+template <typename Type, auto Hook>
+XTR_NODISCARD Type *intrusive_owner(const intrusive_hook *hook) noexcept {
+	using hook_type = typename member_pointer_traits<decltype(Hook)>::member_type;
+	const auto offset = intrusive_hook_offset<Hook>();
+	const auto *member = static_cast<const hook_type *>(hook);
+	auto *bytes = reinterpret_cast<unsigned char *>(const_cast<hook_type *>(member));
+	return reinterpret_cast<Type *>(bytes - offset);
+}
+
+template <typename Type, auto Hook, bool Const>
+class intrusive_list_iterator {
+public:
+	using iterator_category = ::std::bidirectional_iterator_tag;
+	using value_type = Type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = ::std::conditional_t<Const, const Type *, Type *>;
+	using reference = ::std::conditional_t<Const, const Type &, Type &>;
+
+	intrusive_hook *m_node = nullptr;
+
+
+	intrusive_list_iterator() noexcept = default;
+
+	explicit intrusive_list_iterator(intrusive_hook *node) noexcept : m_node{node} {}
+
+	template <bool OtherConst, typename = ::std::enable_if_t<Const && !OtherConst>>
+	intrusive_list_iterator(const intrusive_list_iterator<Type, Hook, OtherConst> &other) noexcept :
+	    m_node{other.m_node} {}
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return *intrusive_owner<Type, Hook>(m_node);
+	}
+
+	XTR_NODISCARD pointer operator->() const noexcept {
+		return intrusive_owner<Type, Hook>(m_node);
+	}
+
+	intrusive_list_iterator &operator++() noexcept {
+		m_node = m_node->m_next;
+		return *this;
+	}
+
+	intrusive_list_iterator operator++(int) noexcept {
+		auto result = *this;
+		++*this;
+		return result;
+	}
+
+	intrusive_list_iterator &operator--() noexcept {
+		m_node = m_node->m_previous;
+		return *this;
+	}
+
+	intrusive_list_iterator operator--(int) noexcept {
+		auto result = *this;
+		--*this;
+		return result;
+	}
+
+	XTR_NODISCARD friend bool operator==(const intrusive_list_iterator &left,
+	                                     const intrusive_list_iterator &right) noexcept {
+		return left.m_node == right.m_node;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const intrusive_list_iterator &left,
+	                                     const intrusive_list_iterator &right) noexcept {
+		return left.m_node != right.m_node;
+	}
+};
+
+} // namespace detail
+
+
+// Doubly linked list of objects that embed an intrusive_hook, never allocates
+template <typename Type, auto Hook>
+class intrusive_list {
+public:
+	static_assert(detail::is_intrusive_hook<Type, Hook>::value,
+	              "Hook must point to a member of Type derived from intrusive_hook");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using difference_type = ::std::ptrdiff_t;
+	using reference = Type &;
+	using const_reference = const Type &;
+	using iterator = detail::intrusive_list_iterator<Type, Hook, false>;
+	using const_iterator = detail::intrusive_list_iterator<Type, Hook, true>;
+
+private:
+	intrusive_hook m_sentinel;
+	size_type m_size;
+
+public:
+	intrusive_list() noexcept : m_sentinel{}, m_size{0} {
+		detail::intrusive_reset(&m_sentinel);
+	}
+
+	intrusive_list(const intrusive_list &) = delete;
+	intrusive_list &operator=(const intrusive_list &) = delete;
+
+	intrusive_list(intrusive_list &&other) noexcept : intrusive_list{} {
+		splice(end(), other);
+	}
+
+	intrusive_list &operator=(intrusive_list &&other) noexcept {
+		if (this != &other) {
+			clear();
+			splice(end(), other);
+		}
+		return *this;
+	}
+
+	~intrusive_list() {
+		clear();
+	}
+
+
+	XTR_NODISCARD iterator begin() noexcept {
+		return iterator{m_sentinel.m_next};
+	}
+
+	XTR_NODISCARD const_iterator begin() const noexcept {
+		return const_iterator{m_sentinel.m_next};
+	}
+
+	XTR_NODISCARD iterator end() noexcept {
+		return iterator{&m_sentinel};
+	}
+
+	XTR_NODISCARD const_iterator end() const noexcept {
+		return const_iterator{const_cast<intrusive_hook *>(&m_sentinel)};
+	}
+
+	// Iterator to an object that is known to be linked into this list
+	XTR_NODISCARD iterator iterator_to(reference value) noexcept {
+		return iterator{&(value.*Hook)};
+	}
+
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD reference front() noexcept {
+		assert(!empty());
+		return *begin();
+	}
+
+	XTR_NODISCARD reference back() noexcept {
+		assert(!empty());
+		return *iterator{m_sentinel.m_previous};
+	}
+
+
+	iterator insert(const_iterator position, reference value) noexcept {
+		detail::intrusive_link_before(position.m_node, &(value.*Hook));
+		++m_size;
+		return iterator{&(value.*Hook)};
+	}
+
+	void push_front(reference value) noexcept {
+		insert(begin(), value);
+	}
+
+	void push_back(reference value) noexcept {
+		insert(end(), value);
+	}
+
+	// Returns an iterator to the object following the erased one
+	iterator erase(const_iterator position) noexcept {
+		assert(position != end());
+		intrusive_hook *next = position.m_node->m_next;
+		detail::intrusive_unlink(position.m_node);
+		--m_size;
+		return iterator{next};
+	}
+
+	void remove(reference value) noexcept {
+		erase(iterator_to(value));
+	}
+
+	void pop_front() noexcept {
+		erase(begin());
+	}
+
+	void pop_back() noexcept {
+		erase(iterator{m_sentinel.m_previous});
+	}
+
+	// Moves every object of other in front of position in constant time
+	void splice(const_iterator position, intrusive_list &other) noexcept {
+		if (other.empty()) {
+			return;
+		}
+		intrusive_hook *first = other.m_sentinel.m_next;
+		intrusive_hook *last = other.m_sentinel.m_previous;
+		intrusive_hook *next = position.m_node;
+		first->m_previous = next->m_previous;
+		next->m_previous->m_next = first;
+		last->m_next = next;
+		next->m_previous = last;
+		m_size += other.m_size;
+		detail::intrusive_reset(&other.m_sentinel);
+		other.m_size = 0;
+	}
+
+	// Unlinks every object so that each can be inserted again
+	void clear() noexcept {
+		while (!empty()) {
+			pop_front();
+		}
+	}
+};
+
+
+namespace detail {
+
+template <typename Type, auto Hook, bool Const>
+class intrusive_set_iterator {
+public:
+	using iterator_category = ::std::forward_iterator_tag;
+	using value_type = Type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = ::std::conditional_t<Const, const Type *, Type *>;
+	using reference = ::std::conditional_t<Const, const Type &, Type &>;
+
+	intrusive_hook *m_node = nullptr;
+	intrusive_hook *m_bucket = nullptr;
+	intrusive_hook *m_last_bucket = nullptr;
+
+
+	intrusive_set_iterator() noexcept = default;
+
+	intrusive_set_iterator(intrusive_hook *node, intrusive_hook *bucket,
+	                       intrusive_hook *last_bucket) noexcept :
+	    m_node{node}, m_bucket{bucket}, m_last_bucket{last_bucket} {
+		skip_empty_buckets();
+	}
+
+	template <bool OtherConst, typename = ::std::enable_if_t<Const && !OtherConst>>
+	intrusive_set_iterator(const intrusive_set_iterator<Type, Hook, OtherConst> &other) noexcept :
+	    m_node{other.m_node}, m_bucket{other.m_bucket}, m_last_bucket{other.m_last_bucket} {}
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return *intrusive_owner<Type, Hook>(m_node);
+	}
+
+	XTR_NODISCARD pointer operator->() const noexcept {
+		return intrusive_owner<Type, Hook>(m_node);
+	}
+
+	intrusive_set_iterator &operator++() noexcept {
+		m_node = m_node->m_next;
+		skip_empty_buckets();
+		return *this;
+	}
+
+	intrusive_set_iterator operator++(int) noexcept {
+		auto result = *this;
+		++*this;
+		return result;
+	}
+
+	XTR_NODISCARD friend bool operator==(const intrusive_set_iterator &left,
+	                                     const intrusive_set_iterator &right) noexcept {
+		return left.m_node == right.m_node;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const intrusive_set_iterator &left,
+	                                     const intrusive_set_iterator &right) noexcept {
+		return left.m_node != right.m_node;
+	}
+
+private:
+	// Reaching the sentinel of a bucket moves on to the next non-empty bucket
+	void skip_empty_buckets() noexcept {
+		while (m_node == m_bucket && m_bucket != m_last_bucket) {
+			++m_bucket;
+			m_node = m_bucket == m_last_bucket ? nullptr : m_bucket->m_next;
+		}
+	}
+};
+
+} // namespace detail
+
+
+// Chained hash set of objects that embed an intrusive_hook, allocates only to grow its buckets
+template <typename Type, auto Hook, typename Hash = ::std::hash<Type>,
+          typename KeyEqual = ::std::equal_to<Type>>
+class intrusive_hash_set {
+public:
+	static_assert(detail::is_intrusive_hook<Type, Hook>::value,
+	              "Hook must point to a member of Type derived from intrusive_hook");
+
+	using key_type = Type;
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using difference_type = ::std::ptrdiff_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using reference = Type &;
+	using const_reference = const Type &;
+	using iterator = detail::intrusive_set_iterator<Type, Hook, false>;
+	using const_iterator = detail::intrusive_set_iterator<Type, Hook, true>;
+
+private:
+	::std::unique_ptr<intrusive_hook[]> m_buckets;
+	size_type m_bucket_count;
+	size_type m_size;
+	hasher m_hash;
+	key_equal m_equal;
+
+public:
+	explicit intrusive_hash_set(size_type bucket_count = 16, const hasher &hash = hasher{},
+	                            const key_equal &equal = key_equal{}) :
+	    m_buckets{}, m_bucket_count{0}, m_size{0}, m_hash{hash}, m_equal{equal} {
+		rehash(bucket_count);
+	}
+
+	intrusive_hash_set(const intrusive_hash_set &) = delete;
+	intrusive_hash_set &operator=(const intrusive_hash_set &) = delete;
+
+	~intrusive_hash_set() {
+		clear();
+	}
+
+
+	XTR_NODISCARD iterator begin() noexcept {
+		return make_iterator(m_buckets.get());
+	}
+
+	XTR_NODISCARD const_iterator begin() const noexcept {
+		return make_iterator(m_buckets.get());
+	}
+
+	XTR_NODISCARD iterator end() noexcept {
+		return iterator{};
+	}
+
+	XTR_NODISCARD const_iterator end() const noexcept {
+		return const_iterator{};
+	}
+
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD size_type bucket_count() const noexcept {
+		return m_bucket_count;
+	}
+
+
+	// Links value unless an equal object is already present, in which case that one is returned
+	::std::pair<iterator, bool> insert(reference value) {
+		if (const auto existing = find(value); existing != end()) {
+			return {existing, false};
+		}
+		if (m_size + 1 > m_bucket_count) {
+			rehash(m_bucket_count * 2);
+		}
+		intrusive_hook *bucket = bucket_for(m_hash(value));
+		detail::intrusive_link_before(bucket->m_next, &(value.*Hook));
+		++m_size;
+		return {iterator{&(value.*Hook), bucket, m_buckets.get() + m_bucket_count}, true};
+	}
+
+	// Accepts any key the hasher and key_equal can compare against stored objects
+	template <typename Key>
+	XTR_NODISCARD iterator find(const Key &key) {
+		intrusive_hook *bucket = bucket_for(m_hash(key));
+		for (intrusive_hook *node = bucket->m_next; node != bucket; node = node->m_next) {
+			if (m_equal(*detail::intrusive_owner<Type, Hook>(node), key)) {
+				return iterator{node, bucket, m_buckets.get() + m_bucket_count};
+			}
+		}
+		return end();
+	}
+
+	template <typename Key>
+	XTR_NODISCARD const_iterator find(const Key &key) const {
+		return const_cast<intrusive_hash_set *>(this)->find(key);
+	}
+
+	template <typename Key>
+	XTR_NODISCARD bool contains(const Key &key) const {
+		return find(key) != end();
+	}
+
+	// Returns an iterator to the object following the erased one
+	iterator erase(const_iterator position) noexcept {
+		iterator next{position.m_node->m_next, position.m_bucket, position.m_last_bucket};
+		detail::intrusive_unlink(position.m_node);
+		--m_size;
+		return next;
+	}
+
+	// Unlinks an object that is known to be in this set without hashing it
+	void remove(reference value) noexcept {
+		detail::intrusive_unlink(&(value.*Hook));
+		--m_size;
+	}
+
+	void clear() noexcept {
+		for (size_type i = 0; i < m_bucket_count; ++i) {
+			intrusive_hook *bucket = &m_buckets[i];
+			while (bucket->m_next != bucket) {
+				detail::intrusive_unlink(bucket->m_next);
+			}
+		}
+		m_size = 0;
+	}
+
+	// Relinks every object into a new power of two sized bucket array
+	void rehash(size_type bucket_count) {
+		bucket_count = detail::bit_ceil(::std::max(bucket_count, size_type{1}));
+		::std::unique_ptr<intrusive_hook[]> buckets{new intrusive_hook[bucket_count]};
+		for (size_type i = 0; i < bucket_count; ++i) {
+			detail::intrusive_reset(&buckets[i]);
+		}
+		for (size_type i = 0; i < m_bucket_count; ++i) {
+			intrusive_hook *bucket = &m_buckets[i];
+			while (bucket->m_next != bucket) {
+				intrusive_hook *node = bucket->m_next;
+				detail::intrusive_unlink(node);
+				const auto hash = m_hash(*detail::intrusive_owner<Type, Hook>(node));
+				const auto mixed = detail::mix_hash(static_cast<::std::uint64_t>(hash));
+				const auto index = static_cast<size_type>(mixed & (bucket_count - 1));
+				detail::intrusive_link_before(buckets[index].m_next, node);
+			}
+		}
+		m_buckets = ::std::move(buckets);
+		m_bucket_count = bucket_count;
+	}
+
+private:
+	intrusive_hook *bucket_for(::std::size_t hash) const noexcept {
+		const auto mixed = detail::mix_hash(static_cast<::std::uint64_t>(hash));
+		return &m_buckets[static_cast<size_type>(mixed & (m_bucket_count - 1))];
+	}
+
+	iterator make_iterator(intrusive_hook *first_bucket) const noexcept {
+		return iterator{first_bucket->m_next, first_bucket, first_bucket + m_bucket_count};
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_INTRUSIVE
+
+
+// Sharded LRU and CLOCK caches with a flat layout in C++
+#if defined(XTR_CACHE) && defined(__cplusplus)
+
+namespace xtr {
+
+struct cache_stats {
+	::std::uint64_t hits = 0;
+	::std::uint64_t misses = 0;
+	::std::uint64_t evictions = 0;
+};
+
+namespace detail {
+
+struct lru_links {
+	::std::uint32_t m_previous;
+	::std::uint32_t m_next;
+};
+
+struct clock_flags {
+	bool m_referenced;
+};
+
+// Entries of a shard live in one array and link to each other by index, a released entry
+// destroys its key and value so that their resources are not held until it is reused
+template <typename Key, typename Value, typename Links>
+struct cache_entry : Links {
+	::std::optional<Key> m_key;
+	::std::optional<Value> m_value;
+	::std::size_t m_hash;
+	::std::uint32_t m_chain; // Next entry in the same bucket, or in the free list
+};
+
+template <typename Key, typename Value, typename Links, typename KeyEqual>
+struct alignas(XTR_CACHE_LINE_SIZE) cache_shard_base {
+
+	using key_type = Key;
+	using mapped_type = Value;
+	using entry_type = cache_entry<Key, Value, Links>;
+
+	static constexpr ::std::uint32_t npos = static_cast<::std::uint32_t>(-1);
+
+	::std::mutex m_mutex;
+	::std::vector<entry_type> m_entries;
+	::std::vector<::std::uint32_t> m_buckets;
+	::std::uint32_t m_free = npos;
+	::std::size_t m_capacity = 0;
+	::std::size_t m_size = 0;
+	cache_stats m_stats;
+	KeyEqual m_equal;
+
+
+	// Reserves every entry up front so that steady state operation never allocates
+	void reset(::std::size_t capacity) {
+		assert(capacity < npos && "cache shard capacity must fit in 32 bits");
+		m_entries.clear();
+		m_entries.reserve(capacity);
+		m_buckets.assign(bit_ceil(capacity), npos);
+		m_free = npos;
+		m_capacity = capacity;
+		m_size = 0;
+	}
+
+	XTR_NODISCARD ::std::uint32_t &bucket(::std::size_t hash) noexcept {
+		return m_buckets[hash & (m_buckets.size() - 1)];
+	}
+
+	XTR_NODISCARD ::std::uint32_t find(::std::size_t hash, const key_type &key) noexcept {
+		for (auto index = bucket(hash); index != npos; index = m_entries[index].m_chain) {
+			const entry_type &entry = m_entries[index];
+			if (entry.m_hash == hash && m_equal(*entry.m_key, key)) {
+				return index;
+			}
+		}
+		return npos;
+	}
+
+	// The shard must not be full, a throwing key or value copy leaves the free entry empty and
+	// on the free list
+	template <typename Parameter>
+	::std::uint32_t emplace(::std::size_t hash, const key_type &key, Parameter &&value) {
+		::std::uint32_t index = m_free;
+		if (index != npos) {
+			entry_type &entry = m_entries[index];
+			entry.m_key.emplace(key);
+			try {
+				entry.m_value.emplace(::std::forward<Parameter>(value));
+			}
+			catch (...) {
+				entry.m_key.reset();
+				throw;
+			}
+			m_free = entry.m_chain;
+			entry.m_hash = hash;
+		}
+		else {
+			index = static_cast<::std::uint32_t>(m_entries.size());
+			m_entries.push_back(
+			    entry_type{Links{}, key, ::std::forward<Parameter>(value), hash, npos});
+		}
+		auto &head = bucket(hash);
+		m_entries[index].m_chain = head;
+		head = index;
+		++m_size;
+		return index;
+	}
+
+	void release(::std::uint32_t index) noexcept {
+		auto *link = &bucket(m_entries[index].m_hash);
+		while (*link != index) {
+			link = &m_entries[*link].m_chain;
+		}
+		*link = m_entries[index].m_chain;
+		m_entries[index].m_key.reset();
+		m_entries[index].m_value.reset();
+		m_entries[index].m_chain = m_free;
+		m_free = index;
+		--m_size;
+	}
+};
+
+template <typename Key, typename Value, typename KeyEqual>
+struct lru_shard : cache_shard_base<Key, Value, lru_links, KeyEqual> {
+
+	using base_type = cache_shard_base<Key, Value, lru_links, KeyEqual>;
+	using base_type::m_entries;
+	using base_type::npos;
+
+	::std::uint32_t m_head = npos; // Most recently used
+	::std::uint32_t m_tail = npos; // Least recently used
+
+
+	void reset(::std::size_t capacity) {
+		base_type::reset(capacity);
+		m_head = npos;
+		m_tail = npos;
+	}
+
+	void on_insert(::std::uint32_t index) noexcept {
+		auto &entry = m_entries[index];
+		entry.m_previous = npos;
+		entry.m_next = m_head;
+		(m_head != npos ? m_entries[m_head].m_previous : m_tail) = index;
+		m_head = index;
+	}
+
+	void on_erase(::std::uint32_t index) noexcept {
+		const auto &entry = m_entries[index];
+		(entry.m_previous != npos ? m_entries[entry.m_previous].m_next : m_head) = entry.m_next;
+		(entry.m_next != npos ? m_entries[entry.m_next].m_previous : m_tail) = entry.m_previous;
+	}
+
+	void on_access(::std::uint32_t index) noexcept {
+		if (index != m_head) {
+			on_erase(index);
+			on_insert(index);
+		}
+	}
+
+	XTR_NODISCARD ::std::uint32_t victim() noexcept {
+		return m_tail;
+	}
+};
+
+// Approximates LRU with a reference bit per entry, so that hits never relink entries
+template <typename Key, typename Value, typename KeyEqual>
+struct clock_shard : cache_shard_base<Key, Value, clock_flags, KeyEqual> {
+
+	using base_type = cache_shard_base<Key, Value, clock_flags, KeyEqual>;
+	using base_type::m_entries;
+
+	::std::size_t m_hand = 0;
+
+
+	void reset(::std::size_t capacity) {
+		base_type::reset(capacity);
+		m_hand = 0;
+	}
+
+	void on_insert(::std::uint32_t index) noexcept {
+		m_entries[index].m_referenced = false;
+	}
+
+	void on_erase(::std::uint32_t) noexcept {}
+
+	void on_access(::std::uint32_t index) noexcept {
+		m_entries[index].m_referenced = true;
+	}
+
+	// Only called on a full shard, where every entry is occupied
+	XTR_NODISCARD ::std::uint32_t victim() noexcept {
+		for (;;) {
+			auto &entry = m_entries[m_hand];
+			const auto index = static_cast<::std::uint32_t>(m_hand);
+			m_hand = m_hand + 1 == m_entries.size() ? 0 : m_hand + 1;
+			if (!entry.m_referenced) {
+				return index;
+			}
+			entry.m_referenced = false;
+		}
+	}
+};
+
+template <typename Shard, typename Hash>
+class sharded_cache {
+public:
+	using key_type = typename Shard::key_type;
+	using mapped_type = typename Shard::mapped_type;
+	using size_type = ::std::size_t;
+	using hasher = Hash;
+
+private:
+	static constexpr auto npos = Shard::npos;
+
+	::std::unique_ptr<Shard[]> m_shards;
+	size_type m_shard_mask;
+	int m_shard_bits;
+	size_type m_capacity;
+	hasher m_hash;
+
+public:
+	// Capacity is split evenly between the shards, each guarded by its own lock
+	explicit sharded_cache(size_type capacity, size_type shards = 16,
+	                       const hasher &hash = hasher{}) :
+	    m_shards{}, m_shard_mask{}, m_shard_bits{}, m_capacity{}, m_hash{hash} {
+		assert(capacity > 0 && "cache capacity must be positive");
+		shards = bit_ceil(shards);
+		while (shards > capacity) {
+			shards /= 2;
+		}
+		m_shards.reset(new Shard[shards]);
+		m_shard_mask = shards - 1;
+		m_shard_bits = bit_width(m_shard_mask);
+		m_capacity = (capacity + m_shard_mask) / shards * shards;
+		for (size_type i = 0; i < shards; ++i) {
+			m_shards[i].reset(m_capacity / shards);
+		}
+	}
+
+	sharded_cache(const sharded_cache &) = delete;
+	sharded_cache &operator=(const sharded_cache &) = delete;
+
+
+	// Returns a copy of the cached value and counts a hit or a miss
+	XTR_NODISCARD ::std::optional<mapped_type> get(const key_type &key) {
+		const auto [shard, hash] = locate(key);
+		const ::std::lock_guard<::std::mutex> lock{shard->m_mutex};
+		const auto index = shard->find(hash, key);
+		if (index == npos) {
+			++shard->m_stats.misses;
+			return ::std::nullopt;
+		}
+		++shard->m_stats.hits;
+		shard->on_access(index);
+		return *shard->m_entries[index].m_value;
+	}
+
+	// Does not affect recency or statistics
+	XTR_NODISCARD bool contains(const key_type &key) const {
+		const auto [shard, hash] = locate(key);
+		const ::std::lock_guard<::std::mutex> lock{shard->m_mutex};
+		return shard->find(hash, key) != npos;
+	}
+
+	// Inserts or assigns the value, evicting an entry of the same shard when it is full
+	template <typename Parameter>
+	void put(const key_type &key, Parameter &&value) {
+		const auto [shard, hash] = locate(key);
+		const ::std::lock_guard<::std::mutex> lock{shard->m_mutex};
+		auto index = shard->find(hash, key);
+		if (index != npos) {
+			*shard->m_entries[index].m_value = ::std::forward<Parameter>(value);
+			shard->on_access(index);
+			return;
+		}
+		if (shard->m_size == shard->m_capacity) {
+			const auto victim = shard->victim();
+			shard->on_erase(victim);
+			shard->release(victim);
+			++shard->m_stats.evictions;
+		}
+		index = shard->emplace(hash, key, ::std::forward<Parameter>(value));
+		shard->on_insert(index);
+	}
+
+	bool erase(const key_type &key) {
+		const auto [shard, hash] = locate(key);
+		const ::std::lock_guard<::std::mutex> lock{shard->m_mutex};
+		const auto index = shard->find(hash, key);
+		if (index == npos) {
+			return false;
+		}
+		shard->on_erase(index);
+		shard->release(index);
+		return true;
+	}
+
+	void clear() {
+		for (size_type i = 0; i <= m_shard_mask; ++i) {
+			const ::std::lock_guard<::std::mutex> lock{m_shards[i].m_mutex};
+			m_shards[i].reset(m_capacity / (m_shard_mask + 1));
+		}
+	}
+
+
+	XTR_NODISCARD size_type size() const {
+		size_type result = 0;
+		for (size_type i = 0; i <= m_shard_mask; ++i) {
+			const ::std::lock_guard<::std::mutex> lock{m_shards[i].m_mutex};
+			result += m_shards[i].m_size;
+		}
+		return result;
+	}
+
+	XTR_NODISCARD size_type capacity() const noexcept {
+		return m_capacity;
+	}
+
+	XTR_NODISCARD cache_stats stats() const {
+		cache_stats result;
+		for (size_type i = 0; i <= m_shard_mask; ++i) {
+			const ::std::lock_guard<::std::mutex> lock{m_shards[i].m_mutex};
+			result.hits += m_shards[i].m_stats.hits;
+			result.misses += m_shards[i].m_stats.misses;
+			result.evictions += m_shards[i].m_stats.evictions;
+		}
+		return result;
+	}
+
+private:
+	::std::pair<Shard *, ::std::size_t> locate(const key_type &key) const {
+		const auto hash = mix_hash(static_cast<::std::uint64_t>(m_hash(key)));
+		return {&m_shards[hash & m_shard_mask], static_cast<::std::size_t>(hash >> m_shard_bits)};
+	}
+};
+
+} // namespace detail
+
+
+// Least recently used cache, hits relink the entry in a per-shard list
+template <typename Key, typename Value, typename Hash = ::std::hash<Key>,
+          typename KeyEqual = ::std::equal_to<Key>>
+using lru_cache = detail::sharded_cache<detail::lru_shard<Key, Value, KeyEqual>, Hash>;
+
+// Approximate least recently used cache, hits only set a reference bit
+template <typename Key, typename Value, typename Hash = ::std::hash<Key>,
+          typename KeyEqual = ::std::equal_to<Key>>
+using clock_cache = detail::sharded_cache<detail::clock_shard<Key, Value, KeyEqual>, Hash>;
+
+} // namespace xtr
+
+#endif // XTR_CACHE
+
+
+// Hierarchical timer wheel in C++
+#if defined(XTR_TIMER_WHEEL) && defined(__cplusplus)
+
+namespace xtr {
+
+// Intrusive hook for objects scheduled in a timer_wheel
+struct timer_hook : intrusive_hook {
+
+	::std::uint64_t m_expiry = 0;
+	::std::uint16_t m_slot = 0;
+
+
+	XTR_NODISCARD ::std::uint64_t expiry() const noexcept {
+		return m_expiry;
+	}
+};
+
+namespace detail {
+
+template <typename Wheel>
+class timer_batch_iterator {
+public:
+	using iterator_category = ::std::input_iterator_tag;
+	using value_type = typename Wheel::value_type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = value_type *;
+	using reference = value_type &;
+
+	Wheel *m_wheel = nullptr;
+	value_type *m_current = nullptr;
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return *m_current;
+	}
+
+	XTR_NODISCARD pointer operator->() const noexcept {
+		return m_current;
+	}
+
+	// Consumes the current timer unless it was already rescheduled or cancelled
+	timer_batch_iterator &operator++() noexcept {
+		m_current = m_wheel->consume_expired(m_current);
+		return *this;
+	}
+
+	XTR_NODISCARD friend bool operator==(const timer_batch_iterator &left,
+	                                     const timer_batch_iterator &right) noexcept {
+		return left.m_current == right.m_current;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const timer_batch_iterator &left,
+	                                     const timer_batch_iterator &right) noexcept {
+		return left.m_current != right.m_current;
+	}
+};
+
+template <typename Wheel>
+class timer_batch {
+public:
+	using value_type = typename Wheel::value_type;
+	using size_type = ::std::size_t;
+	using iterator = timer_batch_iterator<Wheel>;
+
+	Wheel *m_wheel;
+
+
+	XTR_NODISCARD iterator begin() const noexcept {
+		return {m_wheel, m_wheel->consume_expired(nullptr)};
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return {m_wheel, nullptr};
+	}
+};
+
+} // namespace detail
+
+
+// Schedules and cancels timers in constant time, expiry cascades through coarser levels
+template <typename Type, auto Hook>
+class timer_wheel {
+public:
+	static_assert(
+	    ::std::is_base_of_v<timer_hook,
+	                        typename detail::member_pointer_traits<decltype(Hook)>::member_type>,
+	    "Hook must point to a member of Type derived from timer_hook");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using tick_type = ::std::uint64_t;
+	using expired_range = detail::timer_batch<timer_wheel>;
+
+private:
+	using list_type = intrusive_list<Type, Hook>;
+
+	friend class detail::timer_batch_iterator<timer_wheel>;
+	friend class detail::timer_batch<timer_wheel>;
+
+	static constexpr ::std::size_t slot_bits = 8;
+	static constexpr ::std::size_t level_count = 4;
+	static constexpr ::std::size_t slot_count = ::std::size_t{1} << slot_bits;
+	static constexpr ::std::size_t word_count = slot_count / 64;
+	static constexpr auto overflow_slot = static_cast<::std::uint16_t>(level_count * slot_count);
+	static constexpr ::std::uint16_t expired_slot = overflow_slot + 1;
+
+	list_type m_slots[level_count][slot_count];
+	::std::uint64_t m_occupied[level_count][word_count];
+	list_type m_overflow;
+	list_type m_expired;
+	tick_type m_now;
+	size_type m_size;
+
+public:
+	explicit timer_wheel(tick_type now = 0) noexcept : m_occupied{}, m_now{now}, m_size{0} {}
+
+	timer_wheel(const timer_wheel &) = delete;
+	timer_wheel &operator=(const timer_wheel &) = delete;
+
+
+	XTR_NODISCARD tick_type now() const noexcept {
+		return m_now;
+	}
+
+	// Number of timers that have not expired yet
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD bool is_scheduled(const Type &timer) const noexcept {
+		return (timer.*Hook).is_linked();
+	}
+
+
+	// Schedules or reschedules a timer, expiry times that already passed fire on the next tick
+	void schedule(Type &timer, tick_type expiry) noexcept {
+		cancel(timer);
+		(timer.*Hook).m_expiry = ::std::max(expiry, m_now + 1);
+		place(timer);
+		++m_size;
+	}
+
+	// Returns true if the timer was pending or waiting in the expired batch
+	bool cancel(Type &timer) noexcept {
+		timer_hook &hook = timer.*Hook;
+		if (!hook.is_linked()) {
+			return false;
+		}
+		if (hook.m_slot == expired_slot) {
+			m_expired.remove(timer);
+			return true;
+		}
+		list_for(hook.m_slot).remove(timer);
+		if (hook.m_slot < overflow_slot && list_for(hook.m_slot).empty()) {
+			mark(hook.m_slot / slot_count, hook.m_slot % slot_count, false);
+		}
+		--m_size;
+		return true;
+	}
+
+	// Moves time forward and returns the batch of expired timers to iterate, each timer is
+	// unlinked when the iteration moves past it unless it was rescheduled while handling it
+	expired_range advance(tick_type now) noexcept {
+		while (m_now < now) {
+			const auto next = next_event();
+			if (next > now) {
+				m_now = now;
+				break;
+			}
+			m_now = next;
+			if (slot_of(m_now, 0) == 0) {
+				cascade();
+			}
+			expire(slot_of(m_now, 0));
+		}
+		return expired();
+	}
+
+	// Timers that expired but were not iterated past yet
+	XTR_NODISCARD expired_range expired() noexcept {
+		return expired_range{this};
+	}
+
+private:
+	XTR_NODISCARD static ::std::size_t slot_of(tick_type time, ::std::size_t level) noexcept {
+		return static_cast<::std::size_t>(time >> (level * slot_bits)) & (slot_count - 1);
+	}
+
+	list_type &list_for(::std::uint16_t slot) noexcept {
+		return slot == overflow_slot ? m_overflow : m_slots[slot / slot_count][slot % slot_count];
+	}
+
+	void mark(::std::size_t level, ::std::size_t slot, bool occupied) noexcept {
+		const auto bit = ::std::uint64_t{1} << (slot % 64);
+		auto &word = m_occupied[level][slot / 64];
+		word = occupied ? word | bit : word & ~bit;
+	}
+
+	// First occupied slot of a level at or after first, or slot_count if there is none
+	XTR_NODISCARD ::std::size_t next_occupied(::std::size_t level,
+	                                          ::std::size_t first) const noexcept {
+		for (auto i = first / 64; i < word_count && first < slot_count; ++i) {
+			const auto word = m_occupied[level][i] & (~::std::uint64_t{0} << (first % 64));
+			if (word != 0) {
+				return i * 64 + static_cast<::std::size_t>(detail::countr_zero(word));
+			}
+			first = (i + 1) * 64;
+		}
+		return slot_count;
+	}
+
+	// Earliest time at which a slot expires or cascades, so that idle time is skipped at once,
+	// occupied slots always come after the current one of their level and lower levels come
+	// first, and the overflow list is only redistributed at multiples of the whole wheel range
+	XTR_NODISCARD tick_type next_event() const noexcept {
+		for (::std::size_t level = 0; level < level_count; ++level) {
+			const auto slot = next_occupied(level, slot_of(m_now, level) + 1);
+			if (slot < slot_count) {
+				const auto shift = level * slot_bits;
+				const auto round = m_now >> (shift + slot_bits) << slot_bits;
+				return (round | slot) << shift;
+			}
+		}
+		constexpr auto range_bits = level_count * slot_bits;
+		const auto round = m_now >> range_bits;
+		if (m_overflow.empty() || round == ~tick_type{0} >> range_bits) {
+			return ~tick_type{0};
+		}
+		return (round + 1) << range_bits;
+	}
+
+	// Levels are chosen by the highest bit where the expiry differs from the current time
+	void place(Type &timer) noexcept {
+		timer_hook &hook = timer.*Hook;
+		const auto difference = hook.m_expiry ^ m_now;
+		const auto width = static_cast<::std::size_t>(detail::bit_width(difference | 1));
+		const auto level = (width - 1) / slot_bits;
+		if (level >= level_count) {
+			hook.m_slot = overflow_slot;
+			m_overflow.push_back(timer);
+			return;
+		}
+		const auto slot = slot_of(hook.m_expiry, level);
+		hook.m_slot = static_cast<::std::uint16_t>(level * slot_count + slot);
+		m_slots[level][slot].push_back(timer);
+		mark(level, slot, true);
+	}
+
+	// Redistributes the coarser slots whose range starts at the current time, coarsest first
+	void cascade() noexcept {
+		::std::size_t highest = 1;
+		while (highest < level_count && slot_of(m_now, highest) == 0) {
+			++highest;
+		}
+		if (highest == level_count) {
+			redistribute(m_overflow);
+			--highest;
+		}
+		for (auto level = highest; level > 0; --level) {
+			const auto slot = slot_of(m_now, level);
+			mark(level, slot, false);
+			redistribute(m_slots[level][slot]);
+		}
+	}
+
+	void redistribute(list_type &list) noexcept {
+		list_type pending{::std::move(list)};
+		while (!pending.empty()) {
+			Type &timer = pending.front();
+			pending.pop_front();
+			place(timer);
+		}
+	}
+
+	void expire(::std::size_t slot) noexcept {
+		list_type &list = m_slots[0][slot];
+		mark(0, slot, false);
+		while (!list.empty()) {
+			Type &timer = list.front();
+			list.pop_front();
+			(timer.*Hook).m_slot = expired_slot;
+			m_expired.push_back(timer);
+			--m_size;
+		}
+	}
+
+	Type *consume_expired(Type *current) noexcept {
+		if (current != nullptr && (current->*Hook).is_linked()
+		    && (current->*Hook).m_slot == expired_slot) {
+			m_expired.remove(*current);
+		}
+		return m_expired.empty() ? nullptr : &m_expired.front();
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_TIMER_WHEEL
+
+
+// Bit vector with constant time rank and sampled select in C++
+#if defined(XTR_BIT_VECTOR) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+// Position of the set bit with the given rank inside a word
+XTR_NODISCARD inline int select_in_word(::std::uint64_t word, ::std::uint64_t rank) noexcept {
+#if defined(XTR_SIMD_BMI2)
+	return countr_zero(_pdep_u64(::std::uint64_t{1} << rank, word));
+#else
+	int offset = 0;
+	for (int count = popcount(word & 0xFF); rank >= static_cast<::std::uint64_t>(count);
+	     count = popcount(word & 0xFF)) {
+		rank -= static_cast<::std::uint64_t>(count);
+		word >>= 8;
+		offset += 8;
+	}
+	for (; rank > 0; --rank) {
+		word &= word - 1;
+	}
+	return offset + countr_zero(word);
+#endif
+}
+
+class bit_vector_ones_iterator {
+public:
+	using iterator_category = ::std::forward_iterator_tag;
+	using value_type = ::std::size_t;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = const ::std::size_t *;
+	using reference = ::std::size_t;
+
+	const ::std::uint64_t *m_words = nullptr;
+	::std::size_t m_index = 0;
+	::std::size_t m_count = 0;
+	::std::uint64_t m_word = 0;
+
+
+	bit_vector_ones_iterator() noexcept = default;
+
+	bit_vector_ones_iterator(const ::std::uint64_t *words, ::std::size_t index,
+	                         ::std::size_t count) noexcept :
+	    m_words{words}, m_index{index}, m_count{count}, m_word{index < count ? words[index] : 0} {
+		skip_empty_words();
+	}
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return m_index * 64 + static_cast<::std::size_t>(countr_zero(m_word));
+	}
+
+	bit_vector_ones_iterator &operator++() noexcept {
+		m_word &= m_word - 1;
+		skip_empty_words();
+		return *this;
+	}
+
+	bit_vector_ones_iterator operator++(int) noexcept {
+		auto result = *this;
+		++*this;
+		return result;
+	}
+
+	XTR_NODISCARD friend bool operator==(const bit_vector_ones_iterator &left,
+	                                     const bit_vector_ones_iterator &right) noexcept {
+		return left.m_index == right.m_index && left.m_word == right.m_word;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const bit_vector_ones_iterator &left,
+	                                     const bit_vector_ones_iterator &right) noexcept {
+		return !(left == right);
+	}
+
+private:
+	void skip_empty_words() noexcept {
+		while (m_word == 0 && m_index < m_count) {
+			++m_index;
+			m_word = m_index < m_count ? m_words[m_index] : 0;
+		}
+	}
+};
+
+struct bit_vector_ones {
+
+	using size_type = ::std::size_t;
+	using iterator = bit_vector_ones_iterator;
+
+	const ::std::uint64_t *m_words;
+	::std::size_t m_count;
+
+
+	XTR_NODISCARD iterator begin() const noexcept {
+		return {m_words, 0, m_count};
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return {m_words, m_count, m_count};
+	}
+};
+
+} // namespace detail
+
+
+// Packed bits with a rank and select index costing about 3% of the bit storage
+class bit_vector {
+public:
+	using size_type = ::std::size_t;
+	using word_type = ::std::uint64_t;
+
+private:
+	// Each 2048 bit block has one index word, holding its rank relative to the enclosing 2^32 bit
+	// range in the low 32 bits followed by the counts of its first three 512 bit sub-blocks
+	static constexpr size_type block_bits = 2048;
+	static constexpr size_type sub_block_bits = 512;
+	static constexpr size_type words_per_sub_block = sub_block_bits / 64;
+	static constexpr size_type sample_rate = 8192;
+
+	::std::vector<word_type> m_words;
+	size_type m_size = 0;
+	::std::vector<::std::uint64_t> m_ranges;
+	::std::vector<::std::uint64_t> m_blocks;
+	::std::vector<size_type> m_samples;
+	bool m_indexed = false;
+
+public:
+	bit_vector() noexcept = default;
+
+	explicit bit_vector(size_type size, bool value = false) {
+		resize(size, value);
+	}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD const word_type *data() const noexcept {
+		return m_words.data();
+	}
+
+	XTR_NODISCARD size_type word_count() const noexcept {
+		return m_words.size();
+	}
+
+	void resize(size_type size, bool value = false) {
+		if (value && m_size % 64 != 0 && !m_words.empty()) {
+			m_words.back() |= ~word_type{0} << (m_size % 64);
+		}
+		m_words.resize((size + 63) / 64, value ? ~word_type{0} : 0);
+		m_size = size;
+		clear_padding();
+	}
+
+	void push_back(bool value) {
+		if (m_size % 64 == 0) {
+			m_words.push_back(0);
+		}
+		m_words.back() |= static_cast<word_type>(value) << (m_size % 64);
+		++m_size;
+		m_indexed = false;
+	}
+
+
+	XTR_NODISCARD bool test(size_type position) const noexcept {
+		assert(position < m_size);
+		return ((m_words[position / 64] >> (position % 64)) & 1) != 0;
+	}
+
+	XTR_NODISCARD bool operator[](size_type position) const noexcept {
+		return test(position);
+	}
+
+	void set(size_type position, bool value = true) noexcept {
+		assert(position < m_size);
+		const auto bit = word_type{1} << (position % 64);
+		auto &word = m_words[position / 64];
+		word = value ? word | bit : word & ~bit;
+		m_indexed = false;
+	}
+
+	void reset(size_type position) noexcept {
+		set(position, false);
+	}
+
+	void flip(size_type position) noexcept {
+		assert(position < m_size);
+		m_words[position / 64] ^= word_type{1} << (position % 64);
+		m_indexed = false;
+	}
+
+	void flip() noexcept {
+		for (auto &word : m_words) {
+			word = ~word;
+		}
+		clear_padding();
+	}
+
+
+	// Bulk operations work a word at a time and require vectors of equal size
+	bit_vector &operator&=(const bit_vector &other) noexcept {
+		return combine(other, [](word_type left, word_type right) { return left & right; });
+	}
+
+	bit_vector &operator|=(const bit_vector &other) noexcept {
+		return combine(other, [](word_type left, word_type right) { return left | right; });
+	}
+
+	bit_vector &operator^=(const bit_vector &other) noexcept {
+		return combine(other, [](word_type left, word_type right) { return left ^ right; });
+	}
+
+	bit_vector &and_not(const bit_vector &other) noexcept {
+		return combine(other, [](word_type left, word_type right) { return left & ~right; });
+	}
+
+	XTR_NODISCARD friend bit_vector operator&(bit_vector left, const bit_vector &right) {
+		return left &= right;
+	}
+
+	XTR_NODISCARD friend bit_vector operator|(bit_vector left, const bit_vector &right) {
+		return left |= right;
+	}
+
+	XTR_NODISCARD friend bit_vector operator^(bit_vector left, const bit_vector &right) {
+		return left ^= right;
+	}
+
+	XTR_NODISCARD friend bit_vector operator~(bit_vector value) {
+		value.flip();
+		return value;
+	}
+
+
+	XTR_NODISCARD size_type count() const noexcept {
+		size_type result = 0;
+		for (const auto word : m_words) {
+			result += static_cast<size_type>(detail::popcount(word));
+		}
+		return result;
+	}
+
+	// Positions of the set bits in increasing order
+	XTR_NODISCARD detail::bit_vector_ones ones() const noexcept {
+		return {m_words.data(), m_words.size()};
+	}
+
+
+	// Must be called after modifying the bits and before using rank or select
+	void build_index() {
+		const auto blocks = m_size / block_bits + 1;
+		m_ranges.assign((m_size >> 32) + 1, 0);
+		m_blocks.assign(blocks, 0);
+		m_samples.clear();
+		::std::uint64_t total = 0;
+		for (size_type block = 0; block < blocks; ++block) {
+			const auto range = (block * block_bits) >> 32;
+			if (((block * block_bits) & 0xFFFFFFFFu) == 0) {
+				m_ranges[range] = total;
+			}
+			auto entry = total - m_ranges[range];
+			::std::uint64_t block_count = 0;
+			for (size_type sub_block = 0; sub_block < block_bits / sub_block_bits; ++sub_block) {
+				const auto first = (block * block_bits + sub_block * sub_block_bits) / 64;
+				::std::uint64_t count = 0;
+				for (auto i = first; i < first + words_per_sub_block && i < m_words.size(); ++i) {
+					count += static_cast<::std::uint64_t>(detail::popcount(m_words[i]));
+				}
+				if (sub_block < 3) {
+					entry |= count << (32 + 10 * sub_block);
+				}
+				block_count += count;
+			}
+			while (m_samples.size() * sample_rate < total + block_count) {
+				m_samples.push_back(block);
+			}
+			m_blocks[block] = entry;
+			total += block_count;
+		}
+		m_indexed = true;
+	}
+
+	// Number of set bits before position
+	XTR_NODISCARD size_type rank1(size_type position) const noexcept {
+		assert(m_indexed && "build_index must be called after modifying a bit_vector");
+		assert(position <= m_size);
+		const auto block = position / block_bits;
+		const auto entry = m_blocks[block];
+		auto result = block_rank(block);
+		const auto sub_block = (position % block_bits) / sub_block_bits;
+		for (size_type i = 0; i < sub_block; ++i) {
+			result += (entry >> (32 + 10 * i)) & 0x3FF;
+		}
+		const auto last = position / 64;
+		for (auto i = block * (block_bits / 64) + sub_block * words_per_sub_block; i < last; ++i) {
+			result += static_cast<::std::uint64_t>(detail::popcount(m_words[i]));
+		}
+		if (position % 64 != 0) {
+			const auto mask = ~word_type{0} >> (64 - position % 64);
+			result += static_cast<::std::uint64_t>(detail::popcount(m_words[last] & mask));
+		}
+		return static_cast<size_type>(result);
+	}
+
+	XTR_NODISCARD size_type rank0(size_type position) const noexcept {
+		return position - rank1(position);
+	}
+
+	// Position of the set bit with the given zero-based rank, which must be less than count(),
+	// binary searching the blocks between two samples taken every 8192 set bits, so the cost is
+	// constant when bits are dense and logarithmic in the size of the gap when they are sparse
+	XTR_NODISCARD size_type select1(size_type rank) const noexcept {
+		assert(m_indexed && "build_index must be called after modifying a bit_vector");
+		const auto sample = rank / sample_rate;
+		assert(sample < m_samples.size());
+		auto low = m_samples[sample];
+		auto high = sample + 1 < m_samples.size() ? m_samples[sample + 1] + 1 : m_blocks.size();
+		while (high - low > 1) {
+			const auto middle = low + (high - low) / 2;
+			if (block_rank(middle) <= rank) {
+				low = middle;
+			}
+			else {
+				high = middle;
+			}
+		}
+		auto remaining = rank - block_rank(low);
+		const auto entry = m_blocks[low];
+		auto word = low * (block_bits / 64);
+		for (size_type i = 0; i < 3; ++i) {
+			const auto count = (entry >> (32 + 10 * i)) & 0x3FF;
+			if (remaining < count) {
+				break;
+			}
+			remaining -= count;
+			word += words_per_sub_block;
+		}
+		for (;; ++word) {
+			const auto count = static_cast<::std::uint64_t>(detail::popcount(m_words[word]));
+			if (remaining < count) {
+				break;
+			}
+			remaining -= count;
+		}
+		return word * 64 + static_cast<size_type>(detail::select_in_word(m_words[word], remaining));
+	}
+
+private:
+	XTR_NODISCARD ::std::uint64_t block_rank(size_type block) const noexcept {
+		return m_ranges[(block * block_bits) >> 32] + (m_blocks[block] & 0xFFFFFFFFu);
+	}
+
+	void clear_padding() noexcept {
+		if (m_size % 64 != 0) {
+			m_words.back() &= ~word_type{0} >> (64 - m_size % 64);
+		}
+		m_indexed = false;
+	}
+
+	template <typename Operation>
+	bit_vector &combine(const bit_vector &other, Operation operation) noexcept {
+		assert(m_size == other.m_size && "bit_vector sizes must match");
+		for (size_type i = 0; i < m_words.size(); ++i) {
+			m_words[i] = operation(m_words[i], other.m_words[i]);
+		}
+		clear_padding();
+		return *this;
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_BIT_VECTOR
+
+
+// Compressed integer columns in C++
+#if defined(XTR_INTEGER_CODEC) && defined(__cplusplus)
+
+namespace xtr {
+
+enum class integer_encoding : ::std::uint8_t {
+	bit_packed,         // Values packed as they are
+	frame_of_reference, // Offsets from the minimum value of the block
+	delta,              // Zigzag encoded differences, for sorted or slowly changing values
+	automatic           // Whichever of the others gives the narrowest width for each block
+};
+
+namespace detail {
+
+// Blocks use a vertical layout, value i is stored in 128-bit lane i % lanes so that every lane
+// is unpacked by the same shift and mask and SIMD decoding needs no shuffles
+template <typename Unsigned>
+struct packed_block_traits {
+	static constexpr ::std::size_t block_size = 128;
+	static constexpr ::std::size_t lanes = 16 / sizeof(Unsigned);
+	static constexpr ::std::size_t bits = sizeof(Unsigned) * 8;
+
+	XTR_NODISCARD static Unsigned mask(unsigned width) noexcept {
+		return width == bits ? ~Unsigned{0} : static_cast<Unsigned>((Unsigned{1} << width) - 1);
+	}
+
+	XTR_NODISCARD static constexpr ::std::size_t word_count(unsigned width) noexcept {
+		return width * lanes;
+	}
+};
+
+template <typename Unsigned>
+XTR_NODISCARD Unsigned zigzag_encode(Unsigned value) noexcept {
+	using signed_type = ::std::make_signed_t<Unsigned>;
+	const auto sign = static_cast<Unsigned>(static_cast<signed_type>(value) < 0 ? ~Unsigned{0} : 0);
+	return static_cast<Unsigned>(value << 1) ^ sign;
+}
+
+template <typename Unsigned>
+XTR_NODISCARD Unsigned zigzag_decode(Unsigned value) noexcept {
+	return static_cast<Unsigned>((value >> 1) ^ (Unsigned{0} - (value & 1)));
+}
+
+#if defined(XTR_SIMD_SSE2)
+
+template <typename Unsigned>
+XTR_NODISCARD __m128i simd_shift_right(__m128i value, unsigned count) noexcept {
+	if constexpr (sizeof(Unsigned) == 4) {
+		return _mm_srl_epi32(value, _mm_cvtsi32_si128(static_cast<int>(count)));
+	}
+	else {
+		return _mm_srl_epi64(value, _mm_cvtsi32_si128(static_cast<int>(count)));
+	}
+}
+
+template <typename Unsigned>
+XTR_NODISCARD __m128i simd_shift_left(__m128i value, unsigned count) noexcept {
+	if constexpr (sizeof(Unsigned) == 4) {
+		return _mm_sll_epi32(value, _mm_cvtsi32_si128(static_cast<int>(count)));
+	}
+	else {
+		return _mm_sll_epi64(value, _mm_cvtsi32_si128(static_cast<int>(count)));
+	}
+}
+
+template <typename Unsigned>
+XTR_NODISCARD __m128i simd_add(__m128i left, __m128i right) noexcept {
+	if constexpr (sizeof(Unsigned) == 4) {
+		return _mm_add_epi32(left, right);
+	}
+	else {
+		return _mm_add_epi64(left, right);
+	}
+}
+
+template <typename Unsigned>
+XTR_NODISCARD __m128i simd_subtract(__m128i left, __m128i right) noexcept {
+	if constexpr (sizeof(Unsigned) == 4) {
+		return _mm_sub_epi32(left, right);
+	}
+	else {
+		return _mm_sub_epi64(left, right);
+	}
+}
+
+template <typename Unsigned>
+XTR_NODISCARD __m128i simd_broadcast(Unsigned value) noexcept {
+	if constexpr (sizeof(Unsigned) == 4) {
+		return _mm_set1_epi32(static_cast<int>(value));
+	}
+	else {
+		return _mm_set1_epi64x(static_cast<long long>(value));
+	}
+}
+
+#endif
+
+template <typename Unsigned>
+void pack_block(const Unsigned *values, unsigned width, Unsigned *words) noexcept {
+	using traits = packed_block_traits<Unsigned>;
+	::std::fill(words, words + traits::word_count(width), Unsigned{0});
+	if (width == 0) {
+		return;
+	}
+	const auto mask = traits::mask(width);
+	for (::std::size_t row = 0, bit = 0; row < traits::block_size / traits::lanes;
+	     ++row, bit += width) {
+		const auto word = bit / traits::bits * traits::lanes;
+		const auto shift = static_cast<unsigned>(bit % traits::bits);
+		const bool spill = shift + width > traits::bits;
+#if defined(XTR_SIMD_SSE2)
+		const auto input = _mm_and_si128(
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + row * traits::lanes)),
+		    simd_broadcast(mask));
+		auto *target = reinterpret_cast<__m128i *>(words + word);
+		_mm_storeu_si128(target, _mm_or_si128(_mm_loadu_si128(target),
+		                                      simd_shift_left<Unsigned>(input, shift)));
+		if (spill) {
+			_mm_storeu_si128(target + 1,
+			                 simd_shift_right<Unsigned>(input, traits::bits - shift));
+		}
+#else
+		for (::std::size_t lane = 0; lane < traits::lanes; ++lane) {
+			const auto value = static_cast<Unsigned>(values[row * traits::lanes + lane] & mask);
+			words[word + lane] |= static_cast<Unsigned>(value << shift);
+			if (spill) {
+				words[word + traits::lanes + lane] = value >> (traits::bits - shift);
+			}
+		}
+#endif
+	}
+}
+
+template <typename Unsigned>
+void unpack_block(const Unsigned *words, unsigned width, Unsigned *values) noexcept {
+	using traits = packed_block_traits<Unsigned>;
+	if (width == 0) {
+		::std::fill(values, values + traits::block_size, Unsigned{0});
+		return;
+	}
+	const auto mask = traits::mask(width);
+	for (::std::size_t row = 0, bit = 0; row < traits::block_size / traits::lanes;
+	     ++row, bit += width) {
+		const auto word = bit / traits::bits * traits::lanes;
+		const auto shift = static_cast<unsigned>(bit % traits::bits);
+		const bool spill = shift + width > traits::bits;
+#if defined(XTR_SIMD_SSE2)
+		const auto *source = reinterpret_cast<const __m128i *>(words + word);
+		auto output = simd_shift_right<Unsigned>(_mm_loadu_si128(source), shift);
+		if (spill) {
+			output = _mm_or_si128(output, simd_shift_left<Unsigned>(_mm_loadu_si128(source + 1),
+			                                                        traits::bits - shift));
+		}
+		output = _mm_and_si128(output, simd_broadcast(mask));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(values + row * traits::lanes), output);
+#else
+		for (::std::size_t lane = 0; lane < traits::lanes; ++lane) {
+			auto value = static_cast<Unsigned>(words[word + lane] >> shift);
+			if (spill) {
+				value |= static_cast<Unsigned>(words[word + traits::lanes + lane]
+				                               << (traits::bits - shift));
+			}
+			values[row * traits::lanes + lane] = static_cast<Unsigned>(value & mask);
+		}
+#endif
+	}
+}
+
+template <typename Unsigned>
+void add_reference(Unsigned *values, Unsigned reference) noexcept {
+	using traits = packed_block_traits<Unsigned>;
+#if defined(XTR_SIMD_SSE2)
+	const auto offset = simd_broadcast(reference);
+	for (::std::size_t i = 0; i < traits::block_size; i += traits::lanes) {
+		auto *target = reinterpret_cast<__m128i *>(values + i);
+		_mm_storeu_si128(target, simd_add<Unsigned>(_mm_loadu_si128(target), offset));
+	}
+#else
+	for (::std::size_t i = 0; i < traits::block_size; ++i) {
+		values[i] = static_cast<Unsigned>(values[i] + reference);
+	}
+#endif
+}
+
+// Differences are taken between values one row apart, so the prefix sum runs down each lane
+template <typename Unsigned>
+void prefix_sum(Unsigned *values, Unsigned reference) noexcept {
+	using traits = packed_block_traits<Unsigned>;
+#if defined(XTR_SIMD_SSE2)
+	const auto one = simd_broadcast(Unsigned{1});
+	auto running = simd_broadcast(reference);
+	for (::std::size_t i = 0; i < traits::block_size; i += traits::lanes) {
+		auto *target = reinterpret_cast<__m128i *>(values + i);
+		const auto value = _mm_loadu_si128(target);
+		const auto sign = simd_subtract<Unsigned>(_mm_setzero_si128(), _mm_and_si128(value, one));
+		running = simd_add<Unsigned>(running,
+		                             _mm_xor_si128(simd_shift_right<Unsigned>(value, 1), sign));
+		_mm_storeu_si128(target, running);
+	}
+#else
+	for (::std::size_t i = 0; i < traits::block_size; ++i) {
+		const auto previous = i < traits::lanes ? reference : values[i - traits::lanes];
+		values[i] = static_cast<Unsigned>(previous + zigzag_decode(values[i]));
+	}
+#endif
+}
+
+template <typename Unsigned>
+struct packed_block_header {
+	Unsigned m_reference;
+	::std::size_t m_offset; // Index of the first packed word of the block
+	integer_encoding m_encoding;
+	::std::uint8_t m_width;
+};
+
+} // namespace detail
+
+
+template <typename Type>
+class packed_column;
+
+namespace detail {
+
+// Decodes one block at a time into a buffer owned by the iterator
+template <typename Type>
+class packed_column_iterator {
+public:
+	using iterator_category = ::std::input_iterator_tag;
+	using value_type = Type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = const Type *;
+	using reference = Type;
+
+	static constexpr ::std::size_t block_size = 128;
+
+	const packed_column<Type> *m_column = nullptr;
+	::std::size_t m_index = 0;
+	::std::array<Type, block_size> m_buffer;
+
+
+	packed_column_iterator() noexcept = default;
+
+	packed_column_iterator(const packed_column<Type> *column, ::std::size_t index) noexcept :
+	    m_column{column}, m_index{index} {
+		if (m_index < m_column->size()) {
+			m_column->decode_block(m_index / block_size, m_buffer.data());
+		}
+	}
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return m_buffer[m_index % block_size];
+	}
+
+	packed_column_iterator &operator++() noexcept {
+		++m_index;
+		if (m_index % block_size == 0 && m_index < m_column->size()) {
+			m_column->decode_block(m_index / block_size, m_buffer.data());
+		}
+		return *this;
+	}
+
+	XTR_NODISCARD friend bool operator==(const packed_column_iterator &left,
+	                                     const packed_column_iterator &right) noexcept {
+		return left.m_index == right.m_index;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const packed_column_iterator &left,
+	                                     const packed_column_iterator &right) noexcept {
+		return left.m_index != right.m_index;
+	}
+};
+
+} // namespace detail
+
+
+// Immutable column of 32 or 64-bit integers compressed in independent blocks of 128 values
+template <typename Type>
+class packed_column {
+public:
+	static_assert(::std::is_integral_v<Type> && (sizeof(Type) == 4 || sizeof(Type) == 8),
+	              "Type must be a 32 or 64-bit integer");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using iterator = detail::packed_column_iterator<Type>;
+	using const_iterator = iterator;
+
+	static constexpr size_type block_size = 128;
+
+private:
+	using unsigned_type = ::std::make_unsigned_t<Type>;
+	using traits = detail::packed_block_traits<unsigned_type>;
+	using header_type = detail::packed_block_header<unsigned_type>;
+
+	::std::vector<header_type> m_headers;
+	::std::vector<unsigned_type> m_words;
+	size_type m_size = 0;
+
+public:
+	packed_column() noexcept = default;
+
+	packed_column(const Type *values, size_type count,
+	              integer_encoding encoding = integer_encoding::automatic) :
+	    m_headers{}, m_words{}, m_size{count} {
+		m_headers.reserve((count + block_size - 1) / block_size);
+		unsigned_type block[block_size];
+		for (size_type first = 0; first < count; first += block_size) {
+			const auto length = ::std::min(block_size, count - first);
+			for (size_type i = 0; i < block_size; ++i) {
+				// The tail of the last block repeats its final value, which packs to zero bits
+				block[i] = static_cast<unsigned_type>(values[first + ::std::min(i, length - 1)]);
+			}
+			append_block(block, encoding);
+		}
+	}
+
+	template <typename Range>
+	explicit packed_column(const Range &range,
+	                       integer_encoding encoding = integer_encoding::automatic) :
+	    packed_column(::std::data(range), ::std::size(range), encoding) {}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD size_type block_count() const noexcept {
+		return m_headers.size();
+	}
+
+	// Bytes used by the compressed representation
+	XTR_NODISCARD size_type memory_usage() const noexcept {
+		return m_headers.size() * sizeof(header_type) + m_words.size() * sizeof(unsigned_type);
+	}
+
+
+	XTR_NODISCARD iterator begin() const noexcept {
+		return iterator{this, 0};
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return iterator{this, m_size};
+	}
+
+	// Decodes the enclosing block, prefer iteration or decode_block for sequential access
+	XTR_NODISCARD Type operator[](size_type index) const noexcept {
+		assert(index < m_size);
+		Type block[block_size];
+		decode_block(index / block_size, block);
+		return block[index % block_size];
+	}
+
+	// Always writes block_size values, even for the last block
+	void decode_block(size_type block, Type *output) const noexcept {
+		assert(block < m_headers.size());
+		const header_type &header = m_headers[block];
+		unsigned_type values[block_size];
+		detail::unpack_block(m_words.data() + header.m_offset, header.m_width, values);
+		if (header.m_encoding == integer_encoding::frame_of_reference) {
+			detail::add_reference(values, header.m_reference);
+		}
+		else if (header.m_encoding == integer_encoding::delta) {
+			detail::prefix_sum(values, header.m_reference);
+		}
+		::std::memcpy(output, values, sizeof(values));
+	}
+
+	void decode(Type *output) const noexcept {
+		Type block[block_size];
+		for (size_type i = 0; i < m_headers.size(); ++i) {
+			const auto first = i * block_size;
+			decode_block(i, block);
+			::std::copy_n(block, ::std::min(block_size, m_size - first), output + first);
+		}
+	}
+
+private:
+	// Transforms a block for an encoding and returns the bit width it packs to
+	static unsigned transform(const unsigned_type *block, integer_encoding encoding,
+	                          unsigned_type *output, unsigned_type &reference) noexcept {
+		reference = 0;
+		if (encoding == integer_encoding::frame_of_reference) {
+			const auto less = [](unsigned_type left, unsigned_type right) {
+				return static_cast<Type>(left) < static_cast<Type>(right);
+			};
+			reference = *::std::min_element(block, block + block_size, less);
+		}
+		else if (encoding == integer_encoding::delta) {
+			reference = block[0];
+		}
+		unsigned_type bits = 0;
+		for (size_type i = 0; i < block_size; ++i) {
+			if (encoding == integer_encoding::delta) {
+				const auto previous = i < traits::lanes ? reference : block[i - traits::lanes];
+				output[i] = detail::zigzag_encode(static_cast<unsigned_type>(block[i] - previous));
+			}
+			else {
+				output[i] = static_cast<unsigned_type>(block[i] - reference);
+			}
+			bits |= output[i];
+		}
+		return static_cast<unsigned>(detail::bit_width(bits));
+	}
+
+	void append_block(const unsigned_type *block, integer_encoding encoding) {
+		header_type header{0, m_words.size(), encoding, 0};
+		unsigned_type packed[block_size];
+		if (encoding == integer_encoding::automatic) {
+			unsigned_type candidate[block_size];
+			unsigned_type reference;
+			header.m_encoding = integer_encoding::frame_of_reference;
+			header.m_width = static_cast<::std::uint8_t>(
+			    transform(block, integer_encoding::frame_of_reference, packed, header.m_reference));
+			const auto width = transform(block, integer_encoding::delta, candidate, reference);
+			if (width < header.m_width) {
+				header.m_reference = reference;
+				header.m_encoding = integer_encoding::delta;
+				header.m_width = static_cast<::std::uint8_t>(width);
+				::std::memcpy(packed, candidate, sizeof(packed));
+			}
+		}
+		else {
+			header.m_width =
+			    static_cast<::std::uint8_t>(transform(block, encoding, packed, header.m_reference));
+		}
+		m_words.resize(m_words.size() + traits::word_count(header.m_width));
+		detail::pack_block(packed, header.m_width, m_words.data() + header.m_offset);
+		m_headers.push_back(header);
+	}
+};
+
+
+// Largest number of bytes a varint of Type takes
+template <typename Type>
+inline constexpr ::std::size_t varint_max_bytes = (sizeof(Type) * 8 + 6) / 7;
+
+namespace detail {
+
+template <typename Type>
+XTR_NODISCARD ::std::make_unsigned_t<Type> varint_to_unsigned(Type value) noexcept {
+	using unsigned_type = ::std::make_unsigned_t<Type>;
+	if constexpr (::std::is_signed_v<Type>) {
+		return zigzag_encode(static_cast<unsigned_type>(value));
+	}
+	else {
+		return value;
+	}
+}
+
+template <typename Type>
+XTR_NODISCARD Type varint_from_unsigned(::std::make_unsigned_t<Type> value) noexcept {
+	if constexpr (::std::is_signed_v<Type>) {
+		return static_cast<Type>(zigzag_decode(value));
+	}
+	else {
+		return value;
+	}
+}
+
+template <typename Unsigned>
+unsigned char *varint_encode_one(Unsigned value, unsigned char *output) noexcept {
+	for (; value >= 0x80; value >>= 7) {
+		*output++ = static_cast<unsigned char>(value | 0x80);
+	}
+	*output++ = static_cast<unsigned char>(value);
+	return output;
+}
+
+// Rejects values that are truncated or do not fit, and leaves input unchanged when it does
+template <typename Unsigned>
+XTR_NODISCARD bool varint_decode_one(const unsigned char *&input, const unsigned char *end,
+                                     Unsigned &value) noexcept {
+	constexpr unsigned last_shift = (varint_max_bytes<Unsigned> - 1) * 7;
+	constexpr unsigned last_limit = (1u << (sizeof(Unsigned) * 8 - last_shift)) - 1;
+	const auto *current = input;
+	Unsigned result = 0;
+	for (unsigned shift = 0;; shift += 7) {
+		if (current == end) {
+			return false;
+		}
+		const unsigned byte = *current++;
+		if (shift == last_shift && byte > last_limit) {
+			return false;
+		}
+		result |= static_cast<Unsigned>(static_cast<Unsigned>(byte & 0x7f) << shift);
+		if (byte < 0x80) {
+			break;
+		}
+	}
+	value = result;
+	input = current;
+	return true;
+}
+
+#if defined(XTR_SIMD_SSSE3)
+
+template <typename Unsigned>
+XTR_NODISCARD __m128i simd_zigzag_decode(__m128i value) noexcept {
+	const auto sign = simd_subtract<Unsigned>(_mm_setzero_si128(),
+	                                          _mm_and_si128(value, simd_broadcast(Unsigned{1})));
+	return _mm_xor_si128(simd_shift_right<Unsigned>(value, 1), sign);
+}
+
+// Shuffles up to four varints of at most four bytes from the first 12 bytes of a block into
+// 32-bit lanes, indexed by the continuation bits of those 12 bytes
+struct varint_shuffle_entry {
+	unsigned char m_shuffle[16];
+	unsigned char m_consumed;
+	unsigned char m_count;
+};
+
+struct varint_shuffle_table {
+	varint_shuffle_entry m_entries[4096];
+};
+
+inline void build_varint_shuffle(varint_shuffle_table &table) noexcept {
+	for (unsigned mask = 0; mask < 4096; ++mask) {
+		auto &entry = table.m_entries[mask];
+		for (auto &index : entry.m_shuffle) {
+			index = 0x80;
+		}
+		unsigned position = 0;
+		unsigned count = 0;
+		for (; count < 4; ++count) {
+			auto last = position;
+			while (last < 12 && (mask >> last & 1) != 0) {
+				++last;
+			}
+			if (last >= 12 || last - position >= 4) {
+				break;
+			}
+			for (auto byte = position; byte <= last; ++byte) {
+				entry.m_shuffle[count * 4 + byte - position] = static_cast<unsigned char>(byte);
+			}
+			position = last + 1;
+		}
+		entry.m_consumed = static_cast<unsigned char>(position);
+		entry.m_count = static_cast<unsigned char>(count);
+	}
+}
+
+// Built on first use, as a constant the table would slow down every translation unit
+XTR_NODISCARD inline const varint_shuffle_table &varint_shuffle() noexcept {
+	static varint_shuffle_table table;
+	static const bool built = (build_varint_shuffle(table), true);
+	static_cast<void>(built);
+	return table;
+}
+
+// Joins the 7-bit groups of the varint bytes in each 32-bit lane
+XTR_NODISCARD inline __m128i varint_join_lanes(__m128i bytes) noexcept {
+	const auto low = _mm_and_si128(bytes, _mm_set1_epi32(0x007f007f));
+	const auto high = _mm_and_si128(bytes, _mm_set1_epi32(0x7f007f00));
+	const auto pairs = _mm_or_si128(low, _mm_srli_epi32(high, 1));
+	return _mm_or_si128(_mm_and_si128(pairs, _mm_set1_epi32(0x3fff)),
+	                    _mm_srli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0x3fff0000)), 2));
+}
+
+template <typename Type>
+void varint_store_lanes(Type *output, __m128i values) noexcept {
+	using unsigned_type = ::std::make_unsigned_t<Type>;
+	if constexpr (sizeof(Type) == 4) {
+		if constexpr (::std::is_signed_v<Type>) {
+			values = simd_zigzag_decode<unsigned_type>(values);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), values);
+	}
+	else {
+		auto low = _mm_unpacklo_epi32(values, _mm_setzero_si128());
+		auto high = _mm_unpackhi_epi32(values, _mm_setzero_si128());
+		if constexpr (::std::is_signed_v<Type>) {
+			low = simd_zigzag_decode<unsigned_type>(low);
+			high = simd_zigzag_decode<unsigned_type>(high);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), low);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + 2), high);
+	}
+}
+
+#endif
+
+// Decodes until count values are written or the input ends and returns the number decoded, a
+// value that is malformed or cut off by the end of the input is left unread
+template <typename Type>
+::std::size_t varint_decode_some(const unsigned char *&input, const unsigned char *end,
+                                 Type *output, ::std::size_t count) noexcept {
+	using unsigned_type = ::std::make_unsigned_t<Type>;
+	::std::size_t decoded = 0;
+#if defined(XTR_SIMD_SSSE3)
+	const auto &shuffle_table = varint_shuffle();
+	while (end - input >= 16 && count - decoded >= 4) {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+		const auto mask = static_cast<unsigned>(_mm_movemask_epi8(bytes));
+		if (mask == 0 && count - decoded >= 16) {
+			// Sixteen single byte values widen without shuffles
+			const auto low = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+			const auto high = _mm_unpackhi_epi8(bytes, _mm_setzero_si128());
+			varint_store_lanes(output + decoded, _mm_unpacklo_epi16(low, _mm_setzero_si128()));
+			varint_store_lanes(output + decoded + 4,
+			                   _mm_unpackhi_epi16(low, _mm_setzero_si128()));
+			varint_store_lanes(output + decoded + 8,
+			                   _mm_unpacklo_epi16(high, _mm_setzero_si128()));
+			varint_store_lanes(output + decoded + 12,
+			                   _mm_unpackhi_epi16(high, _mm_setzero_si128()));
+			input += 16;
+			decoded += 16;
+			continue;
+		}
+		const auto &entry = shuffle_table.m_entries[mask & 0xfff];
+		if (entry.m_count == 0) {
+			// The first value is longer than four bytes and likely the next ones too
+			for (const auto last = decoded + 4; decoded < last; ++decoded) {
+				unsigned_type value;
+				if (!varint_decode_one(input, end, value)) {
+					return decoded;
+				}
+				output[decoded] = varint_from_unsigned<Type>(value);
+			}
+			continue;
+		}
+		const auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(entry.m_shuffle));
+		varint_store_lanes(output + decoded, varint_join_lanes(_mm_shuffle_epi8(bytes, shuffle)));
+		input += entry.m_consumed;
+		decoded += entry.m_count;
+	}
+#endif
+	for (; decoded < count; ++decoded) {
+		unsigned_type value;
+		if (!varint_decode_one(input, end, value)) {
+			break;
+		}
+		output[decoded] = varint_from_unsigned<Type>(value);
+	}
+	return decoded;
+}
+
+} // namespace detail
+
+
+// Encodes values as LEB128 varints, zigzag encoded for signed types, and returns the number of
+// bytes written, output needs room for count * varint_max_bytes<Type> bytes
+template <typename Type>
+::std::size_t varint_encode_bulk(const Type *values, ::std::size_t count,
+                                 unsigned char *output) noexcept {
+	static_assert(::std::is_integral_v<Type> && (sizeof(Type) == 4 || sizeof(Type) == 8),
+	              "Type must be a 32 or 64-bit integer");
+	auto *const output_begin = output;
+	::std::size_t i = 0;
+#if defined(XTR_SIMD_SSE2)
+	using unsigned_type = ::std::make_unsigned_t<Type>;
+	// Runs of 16 values below 128 are narrowed to bytes together
+	for (; i + 16 <= count; i += 16) {
+		unsigned_type block[16];
+		for (::std::size_t j = 0; j < 16; ++j) {
+			block[j] = detail::varint_to_unsigned(values[i + j]);
+		}
+		__m128i words[4];
+		auto large = _mm_setzero_si128();
+		for (::std::size_t j = 0; j < 4; ++j) {
+			const auto *const source = reinterpret_cast<const __m128i *>(block + j * 4);
+			if constexpr (sizeof(Type) == 4) {
+				words[j] = _mm_loadu_si128(source);
+			}
+			else {
+				const auto first = _mm_loadu_si128(source);
+				const auto second = _mm_loadu_si128(source + 1);
+				words[j] = _mm_unpacklo_epi64(_mm_shuffle_epi32(first, _MM_SHUFFLE(2, 0, 2, 0)),
+				                              _mm_shuffle_epi32(second, _MM_SHUFFLE(2, 0, 2, 0)));
+				// Upper halves must be zero too
+				large = _mm_or_si128(large, _mm_and_si128(_mm_or_si128(first, second),
+				                                          _mm_set_epi32(-1, 0, -1, 0)));
+			}
+			large = _mm_or_si128(large, _mm_srli_epi32(words[j], 7));
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(large, _mm_setzero_si128())) != 0xffff) {
+			for (const auto value : block) {
+				output = detail::varint_encode_one(value, output);
+			}
+			continue;
+		}
+		const auto packed = _mm_packus_epi16(_mm_packs_epi32(words[0], words[1]),
+		                                     _mm_packs_epi32(words[2], words[3]));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), packed);
+		output += 16;
+	}
+#endif
+	for (; i < count; ++i) {
+		output = detail::varint_encode_one(detail::varint_to_unsigned(values[i]), output);
+	}
+	return static_cast<::std::size_t>(output - output_begin);
+}
+
+// Decodes count varints written by varint_encode_bulk and returns the number of bytes read, or
+// nothing when the input ends early or holds a value that does not fit in Type
+template <typename Type>
+XTR_NODISCARD ::std::optional<::std::size_t> varint_decode_bulk(const unsigned char *input,
+                                                                ::std::size_t size, Type *output,
+                                                                ::std::size_t count) noexcept {
+	static_assert(::std::is_integral_v<Type> && (sizeof(Type) == 4 || sizeof(Type) == 8),
+	              "Type must be a 32 or 64-bit integer");
+	const auto *current = input;
+	if (detail::varint_decode_some(current, input + size, output, count) != count) {
+		return ::std::nullopt;
+	}
+	return static_cast<::std::size_t>(current - input);
+}
+
+
+template <typename Type>
+class varint_reader;
+
+namespace detail {
+
+// Decodes ahead into a buffer owned by the iterator
+template <typename Type>
+class varint_reader_iterator {
+public:
+	using iterator_category = ::std::input_iterator_tag;
+	using value_type = Type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = const Type *;
+	using reference = Type;
+
+	static constexpr ::std::size_t buffer_size = 64;
+
+	const unsigned char *m_input = nullptr;
+	const unsigned char *m_end = nullptr;
+	::std::size_t m_index = 0;
+	::std::size_t m_count = 0;
+	::std::array<Type, buffer_size> m_buffer;
+
+
+	varint_reader_iterator() noexcept = default;
+
+	varint_reader_iterator(const unsigned char *input, const unsigned char *end) :
+	    m_input{input}, m_end{end} {
+		refill();
+	}
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return m_buffer[m_index];
+	}
+
+	varint_reader_iterator &operator++() {
+		if (++m_index == m_count) {
+			refill();
+		}
+		return *this;
+	}
+
+	// Iterators compare equal only when both are at the end
+	XTR_NODISCARD friend bool operator==(const varint_reader_iterator &left,
+	                                     const varint_reader_iterator &right) noexcept {
+		return left.m_input == right.m_input && left.m_index == right.m_index
+		       && left.m_count == right.m_count;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const varint_reader_iterator &left,
+	                                     const varint_reader_iterator &right) noexcept {
+		return !(left == right);
+	}
+
+private:
+	void refill() {
+		m_index = 0;
+		m_count = varint_decode_some(m_input, m_end, m_buffer.data(), buffer_size);
+		if (m_count == 0) {
+			if (m_input != m_end) {
+				throw ::std::runtime_error{"xtr::varint_reader: malformed varint"};
+			}
+			m_input = nullptr;
+			m_end = nullptr;
+		}
+	}
+};
+
+} // namespace detail
+
+
+// Single pass view decoding a buffer of varints as it is iterated
+template <typename Type>
+class varint_reader {
+public:
+	static_assert(::std::is_integral_v<Type> && (sizeof(Type) == 4 || sizeof(Type) == 8),
+	              "Type must be a 32 or 64-bit integer");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using iterator = detail::varint_reader_iterator<Type>;
+	using const_iterator = iterator;
+
+private:
+	const unsigned char *m_data;
+	size_type m_size;
+
+public:
+	varint_reader(const unsigned char *data, size_type size) noexcept :
+	    m_data{data}, m_size{size} {}
+
+
+	XTR_NODISCARD iterator begin() const {
+		return iterator{m_data, m_data + m_size};
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return iterator{};
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_INTEGER_CODEC
+
+
+// Priority queues in C++
+#if defined(XTR_HEAP) && defined(__cplusplus)
+
+namespace xtr {
+
+// Addressable heap with Arity children per node stored contiguously, the top element is the one
+// that compares least, so the default is a min-heap suited to decrease-key algorithms
+template <typename Type, ::std::size_t Arity = 4, typename Compare = ::std::less<Type>>
+class dary_heap {
+public:
+	static_assert(Arity >= 2, "Arity must be at least 2");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using value_compare = Compare;
+	using handle_type = ::std::size_t;
+
+	static constexpr handle_type npos = static_cast<handle_type>(-1);
+
+private:
+	struct entry {
+		Type m_value;
+		handle_type m_handle;
+	};
+
+	::std::vector<entry> m_entries;
+	::std::vector<size_type> m_positions; // Position in m_entries of each handle
+	::std::vector<handle_type> m_free;
+	Compare m_compare;
+
+public:
+	explicit dary_heap(const Compare &compare = Compare{}) : m_compare{compare} {}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_entries.size();
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_entries.empty();
+	}
+
+	void reserve(size_type capacity) {
+		m_entries.reserve(capacity);
+		m_positions.reserve(capacity);
+	}
+
+	void clear() noexcept {
+		m_entries.clear();
+		m_positions.clear();
+		m_free.clear();
+	}
+
+
+	XTR_NODISCARD const Type &top() const noexcept {
+		assert(!empty());
+		return m_entries.front().m_value;
+	}
+
+	XTR_NODISCARD handle_type top_handle() const noexcept {
+		assert(!empty());
+		return m_entries.front().m_handle;
+	}
+
+	XTR_NODISCARD bool contains(handle_type handle) const noexcept {
+		return handle < m_positions.size() && m_positions[handle] != npos;
+	}
+
+	XTR_NODISCARD const Type &value(handle_type handle) const noexcept {
+		assert(contains(handle));
+		return m_entries[m_positions[handle]].m_value;
+	}
+
+
+	// Returns a handle that stays valid until the element is popped or erased
+	template <typename Parameter>
+	handle_type push(Parameter &&value) {
+		handle_type handle;
+		if (m_free.empty()) {
+			handle = m_positions.size();
+			m_positions.push_back(m_entries.size());
+		}
+		else {
+			handle = m_free.back();
+			m_free.pop_back();
+			m_positions[handle] = m_entries.size();
+		}
+		m_entries.push_back(entry{::std::forward<Parameter>(value), handle});
+		sift_up(m_entries.size() - 1);
+		return handle;
+	}
+
+	void pop() {
+		assert(!empty());
+		erase(m_entries.front().m_handle);
+	}
+
+	// Replaces the value of an element and restores the heap in either direction
+	template <typename Parameter>
+	void update(handle_type handle, Parameter &&value) {
+		assert(contains(handle));
+		const auto position = m_positions[handle];
+		const bool decreased = m_compare(value, m_entries[position].m_value);
+		m_entries[position].m_value = ::std::forward<Parameter>(value);
+		if (decreased) {
+			sift_up(position);
+		}
+		else {
+			sift_down(position);
+		}
+	}
+
+	void erase(handle_type handle) {
+		assert(contains(handle));
+		const auto position = m_positions[handle];
+		m_positions[handle] = npos;
+		m_free.push_back(handle);
+		if (position + 1 != m_entries.size()) {
+			move_entry(position, ::std::move(m_entries.back()));
+			m_entries.pop_back();
+			if (position > 0 && m_compare(m_entries[position].m_value,
+			                              m_entries[(position - 1) / Arity].m_value)) {
+				sift_up(position);
+			}
+			else {
+				sift_down(position);
+			}
+		}
+		else {
+			m_entries.pop_back();
+		}
+	}
+
+private:
+	void move_entry(size_type position, entry &&value) noexcept {
+		m_positions[value.m_handle] = position;
+		m_entries[position] = ::std::move(value);
+	}
+
+	// Moves a hole instead of swapping, so each level costs one move
+	void sift_up(size_type position) {
+		entry value = ::std::move(m_entries[position]);
+		while (position > 0) {
+			const auto parent = (position - 1) / Arity;
+			if (!m_compare(value.m_value, m_entries[parent].m_value)) {
+				break;
+			}
+			move_entry(position, ::std::move(m_entries[parent]));
+			position = parent;
+		}
+		move_entry(position, ::std::move(value));
+	}
+
+	void sift_down(size_type position) {
+		const auto count = m_entries.size();
+		entry value = ::std::move(m_entries[position]);
+		for (;;) {
+			const auto first = position * Arity + 1;
+			if (first >= count) {
+				break;
+			}
+			const auto last = ::std::min(first + Arity, count);
+			auto best = first;
+			for (auto child = first + 1; child < last; ++child) {
+				if (m_compare(m_entries[child].m_value, m_entries[best].m_value)) {
+					best = child;
+				}
+			}
+			if (!m_compare(m_entries[best].m_value, value.m_value)) {
+				break;
+			}
+			move_entry(position, ::std::move(m_entries[best]));
+			position = best;
+		}
+		move_entry(position, ::std::move(value));
+	}
+};
+
+
+// Min-heap for unsigned keys that never drop below the last popped key, such as distances in
+// Dijkstra's algorithm, with amortized logarithmic cost in the key range instead of the size
+template <typename Key, typename Value>
+class radix_heap {
+public:
+	static_assert(::std::is_unsigned_v<Key>, "Key must be an unsigned integer");
+
+	using key_type = Key;
+	using mapped_type = Value;
+	using value_type = ::std::pair<Key, Value>;
+	using size_type = ::std::size_t;
+
+private:
+	static constexpr ::std::size_t bucket_count = sizeof(Key) * 8 + 1;
+
+	// Bucket i holds keys whose highest bit differing from m_last is bit i - 1
+	::std::vector<value_type> m_buckets[bucket_count];
+	Key m_last = 0;
+	size_type m_size = 0;
+
+public:
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	void clear() noexcept {
+		for (auto &bucket : m_buckets) {
+			bucket.clear();
+		}
+		m_last = 0;
+		m_size = 0;
+	}
+
+
+	// Keys must not be less than the key of the last popped element
+	template <typename Parameter>
+	void push(Key key, Parameter &&value) {
+		assert(key >= m_last && "radix_heap keys must be monotone");
+		m_buckets[bucket_of(key)].emplace_back(key, ::std::forward<Parameter>(value));
+		++m_size;
+	}
+
+	// Not const because finding the minimum redistributes a bucket
+	XTR_NODISCARD value_type &top() {
+		assert(!empty());
+		refill();
+		return m_buckets[0].back();
+	}
+
+	void pop() {
+		assert(!empty());
+		refill();
+		m_buckets[0].pop_back();
+		--m_size;
+	}
+
+private:
+	XTR_NODISCARD ::std::size_t bucket_of(Key key) const noexcept {
+		const auto difference = static_cast<::std::uint64_t>(key ^ m_last);
+		return static_cast<::std::size_t>(detail::bit_width(difference));
+	}
+
+	// Moves the smallest keys into bucket 0, every element only ever moves to lower buckets
+	void refill() {
+		if (!m_buckets[0].empty()) {
+			return;
+		}
+		::std::size_t index = 1;
+		while (m_buckets[index].empty()) {
+			++index;
+		}
+		auto &bucket = m_buckets[index];
+		m_last = bucket.front().first;
+		for (const auto &element : bucket) {
+			m_last = ::std::min(m_last, element.first);
+		}
+		for (auto &element : bucket) {
+			m_buckets[bucket_of(element.first)].push_back(::std::move(element));
+		}
+		bucket.clear();
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_HEAP
+
+
+// Vector with stable element addresses in C++
+#if defined(XTR_STABLE_VECTOR) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+// Default first chunk holds at least 16 KiB so that even the smallest chunk amortizes its
+// allocation and prefetching well
+template <typename Type>
+XTR_NODISCARD constexpr ::std::size_t stable_vector_chunk_size() noexcept {
+	::std::size_t result = 1;
+	while (result * sizeof(Type) < 16384) {
+		result *= 2;
+	}
+	return result;
+}
+
+XTR_NODISCARD constexpr int stable_vector_bits(::std::size_t value) noexcept {
+	int result = 0;
+	for (; value != 0; value >>= 1) {
+		++result;
+	}
+	return result;
+}
+
+template <typename Vector, bool Const>
+class stable_vector_iterator {
+public:
+	using iterator_category = ::std::random_access_iterator_tag;
+	using value_type = typename Vector::value_type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = ::std::conditional_t<Const, const value_type *, value_type *>;
+	using reference = ::std::conditional_t<Const, const value_type &, value_type &>;
+	using container_type = ::std::conditional_t<Const, const Vector, Vector>;
+
+	container_type *m_vector = nullptr;
+	::std::size_t m_index = 0;
+
+
+	stable_vector_iterator() noexcept = default;
+
+	stable_vector_iterator(container_type *vector, ::std::size_t index) noexcept :
+	    m_vector{vector}, m_index{index} {}
+
+	template <bool OtherConst, typename = ::std::enable_if_t<Const && !OtherConst>>
+	stable_vector_iterator(const stable_vector_iterator<Vector, OtherConst> &other) noexcept :
+	    m_vector{other.m_vector}, m_index{other.m_index} {}
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return (*m_vector)[m_index];
+	}
+
+	XTR_NODISCARD pointer operator->() const noexcept {
+		return &(*m_vector)[m_index];
+	}
+
+	XTR_NODISCARD reference operator[](difference_type offset) const noexcept {
+		return *(*this + offset);
+	}
+
+	stable_vector_iterator &operator++() noexcept {
+		++m_index;
+		return *this;
+	}
+
+	stable_vector_iterator operator++(int) noexcept {
+		auto result = *this;
+		++m_index;
+		return result;
+	}
+
+	stable_vector_iterator &operator--() noexcept {
+		--m_index;
+		return *this;
+	}
+
+	stable_vector_iterator operator--(int) noexcept {
+		auto result = *this;
+		--m_index;
+		return result;
+	}
+
+	stable_vector_iterator &operator+=(difference_type offset) noexcept {
+		m_index = static_cast<::std::size_t>(static_cast<difference_type>(m_index) + offset);
+		return *this;
+	}
+
+	stable_vector_iterator &operator-=(difference_type offset) noexcept {
+		return *this += -offset;
+	}
+
+	XTR_NODISCARD friend stable_vector_iterator operator+(stable_vector_iterator iterator,
+	                                                      difference_type offset) noexcept {
+		return iterator += offset;
+	}
+
+	XTR_NODISCARD friend stable_vector_iterator
+	operator+(difference_type offset, stable_vector_iterator iterator) noexcept {
+		return iterator += offset;
+	}
+
+	XTR_NODISCARD friend stable_vector_iterator operator-(stable_vector_iterator iterator,
+	                                                      difference_type offset) noexcept {
+		return iterator -= offset;
+	}
+
+	XTR_NODISCARD friend difference_type operator-(const stable_vector_iterator &left,
+	                                               const stable_vector_iterator &right) noexcept {
+		return static_cast<difference_type>(left.m_index - right.m_index);
+	}
+
+	XTR_NODISCARD friend bool operator==(const stable_vector_iterator &left,
+	                                     const stable_vector_iterator &right) noexcept {
+		return left.m_index == right.m_index;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const stable_vector_iterator &left,
+	                                     const stable_vector_iterator &right) noexcept {
+		return left.m_index != right.m_index;
+	}
+
+	XTR_NODISCARD friend bool operator<(const stable_vector_iterator &left,
+	                                    const stable_vector_iterator &right) noexcept {
+		return left.m_index < right.m_index;
+	}
+
+	XTR_NODISCARD friend bool operator>(const stable_vector_iterator &left,
+	                                    const stable_vector_iterator &right) noexcept {
+		return left.m_index > right.m_index;
+	}
+
+	XTR_NODISCARD friend bool operator<=(const stable_vector_iterator &left,
+	                                     const stable_vector_iterator &right) noexcept {
+		return left.m_index <= right.m_index;
+	}
+
+	XTR_NODISCARD friend bool operator>=(const stable_vector_iterator &left,
+	                                     const stable_vector_iterator &right) noexcept {
+		return left.m_index >= right.m_index;
+	}
+};
+
+} // namespace detail
+
+
+// Sequence stored in cache line aligned chunks where chunk k holds FirstChunkSize << k elements,
+// so growing never moves existing elements and indexing takes one bit width computation.
+// Other threads may read elements below a size() they have loaded while one thread appends with
+// the plain functions, or while any number of threads append with the concurrent_ functions
+template <typename Type, ::std::size_t FirstChunkSize = detail::stable_vector_chunk_size<Type>()>
+class stable_vector {
+public:
+	static_assert(FirstChunkSize > 0 && (FirstChunkSize & (FirstChunkSize - 1)) == 0,
+	              "FirstChunkSize must be a power of two");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using difference_type = ::std::ptrdiff_t;
+	using reference = Type &;
+	using const_reference = const Type &;
+	using iterator = detail::stable_vector_iterator<stable_vector, false>;
+	using const_iterator = detail::stable_vector_iterator<stable_vector, true>;
+
+private:
+	static constexpr int first_bits = detail::stable_vector_bits(FirstChunkSize);
+	static constexpr ::std::size_t max_chunks = sizeof(::std::size_t) * 8 + 1 - first_bits;
+	static constexpr ::std::size_t alignment =
+	    alignof(Type) > XTR_CACHE_LINE_SIZE ? alignof(Type) : XTR_CACHE_LINE_SIZE;
+
+	::std::atomic<Type *> m_chunks[max_chunks] = {};
+	::std::atomic<::std::size_t> m_chunk_count{0};
+	// Indices handed out to appends, ahead of m_size while their elements are constructed
+	::std::atomic<size_type> m_claimed{0};
+	::std::atomic<size_type> m_size{0};
+	// Appends that finished before an earlier one, guarded by the mutex like chunk allocation
+	::std::vector<::std::pair<size_type, size_type>> m_pending;
+	::std::atomic<::std::size_t> m_pending_count{0};
+	::std::mutex m_mutex;
+
+public:
+	stable_vector() noexcept = default;
+
+	stable_vector(const stable_vector &other) : stable_vector{} {
+		reserve(other.size());
+		for (const auto &element : other) {
+			emplace_back(element);
+		}
+	}
+
+	stable_vector(stable_vector &&other) noexcept {
+		swap(other);
+	}
+
+	stable_vector &operator=(stable_vector other) noexcept {
+		swap(other);
+		return *this;
+	}
+
+	~stable_vector() {
+		clear();
+		const auto chunks = m_chunk_count.load(::std::memory_order_relaxed);
+		for (::std::size_t chunk = 0; chunk < chunks; ++chunk) {
+			::operator delete(m_chunks[chunk].load(::std::memory_order_relaxed),
+			                  ::std::align_val_t{alignment});
+		}
+	}
+
+	void swap(stable_vector &other) noexcept {
+		for (::std::size_t chunk = 0; chunk < max_chunks; ++chunk) {
+			swap_relaxed(m_chunks[chunk], other.m_chunks[chunk]);
+		}
+		swap_relaxed(m_chunk_count, other.m_chunk_count);
+		swap_relaxed(m_claimed, other.m_claimed);
+		swap_relaxed(m_size, other.m_size);
+	}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size.load(::std::memory_order_acquire);
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	XTR_NODISCARD size_type capacity() const noexcept {
+		return chunk_start(m_chunk_count.load(::std::memory_order_acquire));
+	}
+
+	// Allocates chunks up front, never moves elements
+	void reserve(size_type capacity) {
+		while (this->capacity() < capacity) {
+			allocate_chunk();
+		}
+	}
+
+
+	XTR_NODISCARD reference operator[](size_type index) noexcept {
+		assert(index < size());
+		return *slot(index);
+	}
+
+	XTR_NODISCARD const_reference operator[](size_type index) const noexcept {
+		assert(index < size());
+		return *slot(index);
+	}
+
+	XTR_NODISCARD reference front() noexcept {
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	XTR_NODISCARD const_reference front() const noexcept {
+		assert(!empty());
+		return (*this)[0];
+	}
+
+	XTR_NODISCARD reference back() noexcept {
+		assert(!empty());
+		return (*this)[size() - 1];
+	}
+
+	XTR_NODISCARD const_reference back() const noexcept {
+		assert(!empty());
+		return (*this)[size() - 1];
+	}
+
+
+	XTR_NODISCARD iterator begin() noexcept {
+		return iterator{this, 0};
+	}
+
+	XTR_NODISCARD iterator end() noexcept {
+		return iterator{this, size()};
+	}
+
+	XTR_NODISCARD const_iterator begin() const noexcept {
+		return const_iterator{this, 0};
+	}
+
+	XTR_NODISCARD const_iterator end() const noexcept {
+		return const_iterator{this, size()};
+	}
+
+	XTR_NODISCARD const_iterator cbegin() const noexcept {
+		return begin();
+	}
+
+	XTR_NODISCARD const_iterator cend() const noexcept {
+		return end();
+	}
+
+
+	template <typename... Parameters>
+	reference emplace_back(Parameters &&...parameters) {
+		const auto index = m_size.load(::std::memory_order_relaxed);
+		if (index == capacity()) {
+			allocate_chunk();
+		}
+		auto *element = ::new (static_cast<void *>(slot(index)))
+		    Type(::std::forward<Parameters>(parameters)...);
+		m_claimed.store(index + 1, ::std::memory_order_relaxed);
+		m_size.store(index + 1, ::std::memory_order_release);
+		return *element;
+	}
+
+	void push_back(const Type &value) {
+		emplace_back(value);
+	}
+
+	void push_back(Type &&value) {
+		emplace_back(::std::move(value));
+	}
+
+	// Appends count copies of value and returns the index of the first one, the copies become
+	// visible together and none are kept if one of them throws
+	size_type grow_by(size_type count, const Type &value = Type{}) {
+		const auto first = m_size.load(::std::memory_order_relaxed);
+		reserve(first + count);
+		size_type index = first;
+		try {
+			for (; index < first + count; ++index) {
+				::new (static_cast<void *>(slot(index))) Type(value);
+			}
+		}
+		catch (...) {
+			while (index > first) {
+				slot(--index)->~Type();
+			}
+			throw;
+		}
+		m_claimed.store(first + count, ::std::memory_order_relaxed);
+		m_size.store(first + count, ::std::memory_order_release);
+		return first;
+	}
+
+
+	// Appends that may run on any number of threads at once, but not alongside the plain
+	// modifiers. Each append claims its indices with one atomic add and its elements become
+	// visible through size() once every earlier append has finished, without waiting for them.
+	// A throwing constructor or allocation would leave a gap that hides every later append, so
+	// it terminates instead
+	template <typename... Parameters>
+	size_type concurrent_emplace_back(Parameters &&...parameters) noexcept {
+		const auto index = m_claimed.fetch_add(1, ::std::memory_order_relaxed);
+		ensure_capacity(index + 1);
+		::new (static_cast<void *>(slot(index))) Type(::std::forward<Parameters>(parameters)...);
+		publish(index, index + 1);
+		return index;
+	}
+
+	size_type concurrent_push_back(const Type &value) noexcept {
+		return concurrent_emplace_back(value);
+	}
+
+	size_type concurrent_push_back(Type &&value) noexcept {
+		return concurrent_emplace_back(::std::move(value));
+	}
+
+	// Appends count copies of value and returns the index of the first one
+	size_type concurrent_grow_by(size_type count, const Type &value = Type{}) noexcept {
+		const auto first = m_claimed.fetch_add(count, ::std::memory_order_relaxed);
+		ensure_capacity(first + count);
+		for (size_type index = first; index < first + count; ++index) {
+			::new (static_cast<void *>(slot(index))) Type(value);
+		}
+		publish(first, first + count);
+		return first;
+	}
+
+
+	void pop_back() noexcept {
+		assert(!empty());
+		const auto index = m_size.load(::std::memory_order_relaxed) - 1;
+		m_claimed.store(index, ::std::memory_order_relaxed);
+		m_size.store(index, ::std::memory_order_release);
+		slot(index)->~Type();
+	}
+
+	// Destroys all elements but keeps the chunks for reuse
+	void clear() noexcept {
+		const auto count = m_size.load(::std::memory_order_relaxed);
+		m_claimed.store(0, ::std::memory_order_relaxed);
+		m_size.store(0, ::std::memory_order_release);
+		if constexpr (!::std::is_trivially_destructible_v<Type>) {
+			for (size_type index = 0; index < count; ++index) {
+				slot(index)->~Type();
+			}
+		}
+	}
+
+	// Frees chunks that hold no elements
+	void shrink_to_fit() noexcept {
+		const auto count = m_size.load(::std::memory_order_relaxed);
+		auto chunks = m_chunk_count.load(::std::memory_order_relaxed);
+		while (chunks > 0 && chunk_start(chunks - 1) >= count) {
+			--chunks;
+			::operator delete(m_chunks[chunks].exchange(nullptr, ::std::memory_order_relaxed),
+			                  ::std::align_val_t{alignment});
+		}
+		m_chunk_count.store(chunks, ::std::memory_order_relaxed);
+	}
+
+private:
+	template <typename Value>
+	static void swap_relaxed(::std::atomic<Value> &left, ::std::atomic<Value> &right) noexcept {
+		const auto value = left.load(::std::memory_order_relaxed);
+		left.store(right.load(::std::memory_order_relaxed), ::std::memory_order_relaxed);
+		right.store(value, ::std::memory_order_relaxed);
+	}
+
+	XTR_NODISCARD static ::std::size_t chunk_of(size_type index) noexcept {
+		const auto chunk =
+		    static_cast<::std::size_t>(detail::bit_width(index + FirstChunkSize) - first_bits);
+		assert_assume(chunk < max_chunks);
+		return chunk;
+	}
+
+	// The chunk pointer is published before any element in it, so readers load it relaxed
+	XTR_NODISCARD Type *slot(size_type index) const noexcept {
+		const auto chunk = chunk_of(index);
+		return m_chunks[chunk].load(::std::memory_order_relaxed)
+		       + (index + FirstChunkSize - (FirstChunkSize << chunk));
+	}
+
+	// Index of the first element in a chunk, equal to the capacity of all chunks before it
+	XTR_NODISCARD static size_type chunk_start(::std::size_t chunk) noexcept {
+		return (FirstChunkSize << chunk) - FirstChunkSize;
+	}
+
+	void allocate_chunk() {
+		const auto chunk = m_chunk_count.load(::std::memory_order_relaxed);
+		assert(chunk < max_chunks);
+		const auto bytes = (FirstChunkSize << chunk) * sizeof(Type);
+		m_chunks[chunk].store(
+		    static_cast<Type *>(::operator new(bytes, ::std::align_val_t{alignment})),
+		    ::std::memory_order_release);
+		m_chunk_count.store(chunk + 1, ::std::memory_order_release);
+	}
+
+	// Chunks are allocated in order under the lock, so once the chunk of the last index exists
+	// every chunk before it does too
+	void ensure_capacity(size_type end) {
+		if (end == 0) {
+			return;
+		}
+		const auto last = chunk_of(end - 1);
+		if (m_chunks[last].load(::std::memory_order_acquire) != nullptr) {
+			return;
+		}
+		::std::lock_guard<::std::mutex> lock{m_mutex};
+		while (m_chunk_count.load(::std::memory_order_relaxed) <= last) {
+			allocate_chunk();
+		}
+	}
+
+	// Makes [first, last) visible if every earlier append is, otherwise parks it for the append
+	// that closes the gap. Either the parking append sees the size move past the gap, or the
+	// append that moved it sees the parked count, because both sides use sequential consistency
+	void publish(size_type first, size_type last) {
+		auto expected = first;
+		if (m_size.compare_exchange_strong(expected, last, ::std::memory_order_seq_cst)) {
+			if (m_pending_count.load(::std::memory_order_seq_cst) == 0) {
+				return;
+			}
+			::std::lock_guard<::std::mutex> lock{m_mutex};
+			drain_pending();
+			return;
+		}
+		::std::lock_guard<::std::mutex> lock{m_mutex};
+		m_pending.emplace_back(first, last);
+		m_pending_count.fetch_add(1, ::std::memory_order_seq_cst);
+		drain_pending();
+	}
+
+	// Publishes parked appends that now follow the size, only their own append could have moved
+	// the size past their first index
+	void drain_pending() {
+		for (auto position = m_pending.begin(); position != m_pending.end();) {
+			if (position->first != m_size.load(::std::memory_order_seq_cst)) {
+				++position;
+				continue;
+			}
+			m_size.store(position->second, ::std::memory_order_release);
+			*position = m_pending.back();
+			m_pending.pop_back();
+			m_pending_count.fetch_sub(1, ::std::memory_order_relaxed);
+			position = m_pending.begin();
+		}
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_STABLE_VECTOR
+
+
+// Non-allocating function wrappers in C++
+#if defined(XTR_FUNCTION) && defined(__cplusplus)
+
+namespace xtr {
+
+template <typename Signature>
+class function_ref;
+
+template <typename Signature, ::std::size_t Capacity = 4 * sizeof(void *),
+          ::std::size_t Alignment = alignof(::std::max_align_t)>
+class inplace_function;
+
+namespace detail {
+
+// Calls a callable and converts its result, discarding it when the signature returns void
+template <typename Result, typename Callable, typename... Parameters>
+Result invoke_as(Callable &&callable, Parameters &&...parameters) {
+	if constexpr (::std::is_void_v<Result>) {
+		::std::invoke(::std::forward<Callable>(callable),
+		              ::std::forward<Parameters>(parameters)...);
+	}
+	else {
+		return ::std::invoke(::std::forward<Callable>(callable),
+		                     ::std::forward<Parameters>(parameters)...);
+	}
+}
+
+// Object pointers and function pointers may differ in size, so each has its own member
+union function_target {
+	void *m_object;
+	void (*m_function)();
+};
+
+template <typename Type>
+inline constexpr bool is_function_pointer_v =
+    ::std::is_pointer_v<Type> && ::std::is_function_v<::std::remove_pointer_t<Type>>;
+
+template <typename Type>
+inline constexpr bool is_inplace_function_v = false;
+
+template <typename Signature, ::std::size_t Capacity, ::std::size_t Alignment>
+inline constexpr bool is_inplace_function_v<inplace_function<Signature, Capacity, Alignment>> =
+    true;
+
+enum class inplace_operation { copy, move, destroy };
+
+// Copies or moves the callable in source to target, moving also destroys the source
+template <typename Stored>
+void inplace_manage(inplace_operation operation, void *target, void *source) {
+	auto *const stored = static_cast<Stored *>(source);
+	switch (operation) {
+	case inplace_operation::copy:
+		::new (target) Stored(*stored);
+		break;
+	case inplace_operation::move:
+		::new (target) Stored(::std::move(*stored));
+		stored->~Stored();
+		break;
+	case inplace_operation::destroy:
+		stored->~Stored();
+		break;
+	}
+}
+
+} // namespace detail
+
+
+// Non-owning reference to a callable in two pointers, the callable must outlive the reference
+// but functions and function pointers are stored by value
+template <typename Result, typename... Parameters>
+class function_ref<Result(Parameters...)> {
+	detail::function_target m_target;
+	Result (*m_invoke)(detail::function_target, Parameters...);
+
+public:
+	template <typename Callable,
+	          typename = ::std::enable_if_t<
+	              !::std::is_same_v<::std::decay_t<Callable>, function_ref>
+	              && ::std::is_invocable_r_v<Result, Callable &, Parameters...>>>
+	function_ref(Callable &&callable) noexcept {
+		using pointer_type = ::std::decay_t<Callable>;
+		if constexpr (detail::is_function_pointer_v<pointer_type>) {
+			const pointer_type function = callable;
+			assert(function != nullptr);
+			m_target.m_function = reinterpret_cast<void (*)()>(function);
+			m_invoke = [](detail::function_target target, Parameters... parameters) -> Result {
+				return detail::invoke_as<Result>(reinterpret_cast<pointer_type>(target.m_function),
+				                                 ::std::forward<Parameters>(parameters)...);
+			};
+		}
+		else {
+			using object_type = ::std::remove_reference_t<Callable>;
+			m_target.m_object =
+			    const_cast<void *>(static_cast<const void *>(::std::addressof(callable)));
+			m_invoke = [](detail::function_target target, Parameters... parameters) -> Result {
+				return detail::invoke_as<Result>(*static_cast<object_type *>(target.m_object),
+				                                 ::std::forward<Parameters>(parameters)...);
+			};
+		}
+	}
+
+
+	Result operator()(Parameters... parameters) const {
+		return m_invoke(m_target, ::std::forward<Parameters>(parameters)...);
+	}
+};
+
+
+// Owning callable wrapper that never allocates, the callable must fit in Capacity bytes and is
+// copied with plain byte copies when it is trivially copyable
+template <typename Result, typename... Parameters, ::std::size_t Capacity, ::std::size_t Alignment>
+class inplace_function<Result(Parameters...), Capacity, Alignment> {
+	alignas(Alignment) mutable unsigned char m_buffer[Capacity];
+	Result (*m_invoke)(void *, Parameters...) = nullptr;
+	void (*m_manage)(detail::inplace_operation, void *, void *) = nullptr;
+
+public:
+	inplace_function() noexcept = default;
+
+	inplace_function(::std::nullptr_t) noexcept {}
+
+	template <typename Callable, typename Stored = ::std::decay_t<Callable>,
+	          typename = ::std::enable_if_t<
+	              !detail::is_inplace_function_v<Stored>
+	              && ::std::is_invocable_r_v<Result, Stored &, Parameters...>>>
+	inplace_function(Callable &&callable) {
+		static_assert(sizeof(Stored) <= Capacity, "Callable does not fit in the capacity");
+		static_assert(Alignment % alignof(Stored) == 0, "Callable needs a stricter alignment");
+		static_assert(::std::is_copy_constructible_v<Stored>
+		                  && ::std::is_nothrow_move_constructible_v<Stored>,
+		              "Callable must be copyable and nothrow movable");
+		::new (static_cast<void *>(m_buffer)) Stored(::std::forward<Callable>(callable));
+		m_invoke = [](void *target, Parameters... parameters) -> Result {
+			return detail::invoke_as<Result>(*static_cast<Stored *>(target),
+			                                 ::std::forward<Parameters>(parameters)...);
+		};
+		if constexpr (!::std::is_trivially_copyable_v<Stored>) {
+			m_manage = &detail::inplace_manage<Stored>;
+		}
+	}
+
+	inplace_function(const inplace_function &other) :
+	    m_invoke(other.m_invoke), m_manage(other.m_manage) {
+		if (m_manage != nullptr) {
+			m_manage(detail::inplace_operation::copy, m_buffer, other.m_buffer);
+		}
+		else if (m_invoke != nullptr) {
+			::std::memcpy(m_buffer, other.m_buffer, Capacity);
+		}
+	}
+
+	inplace_function(inplace_function &&other) noexcept {
+		take(other);
+	}
+
+	// Callables and nullptr are assigned through the converting constructors
+	inplace_function &operator=(inplace_function other) noexcept {
+		clear();
+		take(other);
+		return *this;
+	}
+
+	~inplace_function() {
+		clear();
+	}
+
+	void swap(inplace_function &other) noexcept {
+		inplace_function temporary{::std::move(other)};
+		other.take(*this);
+		take(temporary);
+	}
+
+
+	XTR_NODISCARD explicit operator bool() const noexcept {
+		return m_invoke != nullptr;
+	}
+
+	Result operator()(Parameters... parameters) const {
+		assert(m_invoke != nullptr);
+		return m_invoke(m_buffer, ::std::forward<Parameters>(parameters)...);
+	}
+
+private:
+	void clear() noexcept {
+		if (m_manage != nullptr) {
+			m_manage(detail::inplace_operation::destroy, nullptr, m_buffer);
+		}
+		m_invoke = nullptr;
+		m_manage = nullptr;
+	}
+
+	// Moves the callable out of other, this must be empty and other is left empty
+	void take(inplace_function &other) noexcept {
+		if (other.m_manage != nullptr) {
+			other.m_manage(detail::inplace_operation::move, m_buffer, other.m_buffer);
+		}
+		else if (other.m_invoke != nullptr) {
+			::std::memcpy(m_buffer, other.m_buffer, Capacity);
+		}
+		m_invoke = other.m_invoke;
+		m_manage = other.m_manage;
+		other.m_invoke = nullptr;
+		other.m_manage = nullptr;
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_FUNCTION
+
+
+// Thread pool and parallel algorithms in C++
+#if defined(XTR_PARALLEL) && defined(__cplusplus)
+
+namespace xtr {
+
+class thread_pool;
+
+namespace detail {
+
+// Pool whose task the current thread is running, used to run nested calls serially
+XTR_NODISCARD inline thread_pool *&current_thread_pool() noexcept {
+	static thread_local thread_pool *pool = nullptr;
+	return pool;
+}
+
+} // namespace detail
+
+
+// Fork-join pool of threads that run blocks of a single job at a time, the calling thread
+// takes part in its own job, and tasks must not throw
+class thread_pool {
+public:
+	using size_type = ::std::size_t;
+
+private:
+	struct job {
+		function_ref<void(size_type)> m_function;
+		size_type m_task_count;
+		::std::atomic<size_type> m_next{0};
+	};
+
+	::std::vector<::std::thread> m_threads;
+	::std::mutex m_mutex;
+	::std::mutex m_run_mutex;
+	::std::condition_variable m_wake;
+	::std::condition_variable m_done;
+	job *m_job = nullptr;
+	::std::uint64_t m_generation = 0;
+	size_type m_active = 0;
+	bool m_stop = false;
+
+public:
+	// Concurrency counts the calling thread, so one less worker thread is started
+	explicit thread_pool(size_type concurrency = ::std::thread::hardware_concurrency()) {
+		for (size_type index = 1; index < concurrency; ++index) {
+			m_threads.emplace_back([this] { work(); });
+		}
+	}
+
+	thread_pool(const thread_pool &) = delete;
+	thread_pool &operator=(const thread_pool &) = delete;
+
+	~thread_pool() {
+		{
+			::std::lock_guard<::std::mutex> lock{m_mutex};
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto &thread : m_threads) {
+			thread.join();
+		}
+	}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_threads.size() + 1;
+	}
+
+	// Calls function(task) for every task below task_count and returns when all have finished
+	template <typename Function>
+	void run(size_type task_count, Function &&function) {
+		if (task_count == 0) {
+			return;
+		}
+		if (task_count == 1 || m_threads.empty() || detail::current_thread_pool() == this) {
+			for (size_type task = 0; task < task_count; ++task) {
+				function(task);
+			}
+			return;
+		}
+
+		job current{function, task_count};
+
+		::std::lock_guard<::std::mutex> run_lock{m_run_mutex};
+		{
+			::std::lock_guard<::std::mutex> lock{m_mutex};
+			m_job = &current;
+			++m_generation;
+		}
+		m_wake.notify_all();
+		execute(current);
+
+		// Workers that joined late may still be running the last tasks
+		::std::unique_lock<::std::mutex> lock{m_mutex};
+		m_job = nullptr;
+		m_done.wait(lock, [this] { return m_active == 0; });
+	}
+
+private:
+	void execute(job &current) noexcept {
+		auto *const previous = detail::current_thread_pool();
+		detail::current_thread_pool() = this;
+		for (;;) {
+			const auto task = current.m_next.fetch_add(1, ::std::memory_order_relaxed);
+			if (task >= current.m_task_count) {
+				break;
+			}
+			current.m_function(task);
+		}
+		detail::current_thread_pool() = previous;
+	}
+
+	void work() {
+		::std::uint64_t seen = 0;
+		::std::unique_lock<::std::mutex> lock{m_mutex};
+		for (;;) {
+			m_wake.wait(lock, [&] { return m_stop || (m_job != nullptr && m_generation != seen); });
+			if (m_stop) {
+				return;
+			}
+			seen = m_generation;
+			auto *const current = m_job;
+			++m_active;
+			lock.unlock();
+			execute(*current);
+			lock.lock();
+			if (--m_active == 0) {
+				m_done.notify_all();
+			}
+		}
+	}
+};
+
+
+// Pool shared by the parallel algorithms when none is given
+XTR_NODISCARD inline thread_pool &default_thread_pool() {
+	static thread_pool pool;
+	return pool;
+}
+
+
+namespace detail {
+
+// Elements below this count per block are not worth waking another thread for
+inline constexpr ::std::size_t parallel_grain = 16384;
+
+XTR_NODISCARD inline ::std::size_t parallel_block_count(const thread_pool &pool,
+                                                        ::std::size_t count) noexcept {
+	const auto blocks = (count + parallel_grain - 1) / parallel_grain;
+	return blocks < pool.size() ? blocks : pool.size();
+}
+
+// Splits count elements into blocks whose sizes differ by at most one
+XTR_NODISCARD inline ::std::size_t parallel_block_begin(::std::size_t count, ::std::size_t blocks,
+                                                        ::std::size_t block) noexcept {
+	const auto remainder = count % blocks;
+	return count / blocks * block + (block < remainder ? block : remainder);
+}
+
+template <typename Range>
+using range_value_t = ::std::remove_cv_t<::std::remove_reference_t<decltype(*::std::data(
+    ::std::declval<Range &>()))>>;
+
+template <typename Operation, typename Type>
+inline constexpr bool is_plus_v =
+    ::std::is_same_v<Operation, ::std::plus<>> || ::std::is_same_v<Operation, ::std::plus<Type>>;
+
+// Integer sums that SSE2 can compute four or two lanes at a time
+template <typename Operation, typename Source, typename Target>
+inline constexpr bool is_simd_sum_v =
+    ::std::is_same_v<Source, Target> && ::std::is_integral_v<Target>
+    && !::std::is_same_v<Target, bool> && (sizeof(Target) == 4 || sizeof(Target) == 8)
+    && is_plus_v<Operation, Target>;
+
+template <typename Target, typename Source, typename Operation>
+XTR_NODISCARD Target reduce_block(const Source *source, ::std::size_t count, Operation &operation) {
+	Target result = source[0];
+	::std::size_t index = 1;
+#if defined(XTR_SIMD_SSE2)
+	if constexpr (is_simd_sum_v<Operation, Source, Target>) {
+		constexpr ::std::size_t lanes = 16 / sizeof(Target);
+		auto sum = _mm_setzero_si128();
+		for (; index + lanes <= count; index += lanes) {
+			const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + index));
+			sum = sizeof(Target) == 4 ? _mm_add_epi32(sum, value) : _mm_add_epi64(sum, value);
+		}
+		alignas(16) Target lane_sums[lanes];
+		_mm_store_si128(reinterpret_cast<__m128i *>(lane_sums), sum);
+		for (const auto lane_sum : lane_sums) {
+			result = static_cast<Target>(result + lane_sum);
+		}
+	}
+#endif
+	for (; index < count; ++index) {
+		result = operation(result, source[index]);
+	}
+	return result;
+}
+
+template <typename Source, typename Target, typename Operation>
+void scan_block(const Source *source, Target *target, ::std::size_t count, const Target *carry,
+                Operation &operation) {
+	Target running = carry != nullptr ? operation(*carry, source[0]) : Target(source[0]);
+	target[0] = running;
+	::std::size_t index = 1;
+#if defined(XTR_SIMD_SSE2)
+	if constexpr (is_simd_sum_v<Operation, Source, Target>) {
+		constexpr ::std::size_t lanes = 16 / sizeof(Target);
+		// Log-step shifted adds give the prefix sum within a register, the last lane is the carry
+		auto running_vector = sizeof(Target) == 4
+		                          ? _mm_set1_epi32(static_cast<int>(running))
+		                          : _mm_set1_epi64x(static_cast<long long>(running));
+		for (; index + lanes <= count; index += lanes) {
+			auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + index));
+			if constexpr (sizeof(Target) == 4) {
+				value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+				value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+				value = _mm_add_epi32(value, running_vector);
+				running_vector = _mm_shuffle_epi32(value, 0xFF);
+			}
+			else {
+				value = _mm_add_epi64(value, _mm_slli_si128(value, 8));
+				value = _mm_add_epi64(value, running_vector);
+				running_vector = _mm_shuffle_epi32(value, 0xEE);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(target + index), value);
+		}
+		running = target[index - 1];
+	}
+#endif
+	for (; index < count; ++index) {
+		running = operation(running, source[index]);
+		target[index] = running;
+	}
+}
+
+// Matches of the first compaction pass, one bit per element, with block boundaries rounded to
+// whole words so that no two blocks write the same word
+struct compact_matches {
+	::std::vector<::std::uint64_t> m_bits;
+	::std::vector<::std::size_t> m_offsets;
+	::std::size_t m_count;
+
+
+	XTR_NODISCARD ::std::size_t block_begin(::std::size_t block) const noexcept {
+		const auto blocks = m_offsets.size() - 1;
+		const auto index = parallel_block_begin(m_bits.size(), blocks, block) * 64;
+		return index < m_count ? index : m_count;
+	}
+};
+
+// First pass of compaction, records which elements match and turns the number of matches per
+// block into block offsets, so that the predicate is called once per element
+template <typename Source, typename Predicate>
+XTR_NODISCARD ::std::size_t compact_offsets(thread_pool &pool, const Source *source,
+                                            ::std::size_t count, Predicate &predicate,
+                                            compact_matches &matches) {
+	const auto blocks = parallel_block_count(pool, count);
+	matches.m_bits.resize((count + 63) / 64);
+	matches.m_offsets.assign(blocks + 1, 0);
+	matches.m_count = count;
+	pool.run(blocks, [&](::std::size_t block) {
+		const auto first = matches.block_begin(block);
+		const auto last = matches.block_begin(block + 1);
+		::std::size_t total = 0;
+		for (auto index = first; index < last; index += 64) {
+			const auto end = last - index < 64 ? last : index + 64;
+			::std::uint64_t bits = 0;
+			for (auto i = index; i < end; ++i) {
+				bits |= static_cast<::std::uint64_t>(static_cast<bool>(predicate(source[i])))
+				        << (i - index);
+			}
+			matches.m_bits[index / 64] = bits;
+			total += static_cast<::std::size_t>(popcount(bits));
+		}
+		matches.m_offsets[block + 1] = total;
+	});
+	for (::std::size_t block = 1; block <= blocks; ++block) {
+		matches.m_offsets[block] += matches.m_offsets[block - 1];
+	}
+	return matches.m_offsets[blocks];
+}
+
+// Second pass of compaction, copies the elements whose bits the first pass set
+template <typename Source, typename Target>
+void compact_blocks(thread_pool &pool, const Source *source, Target *target,
+                    const compact_matches &matches) {
+	const auto blocks = matches.m_offsets.size() - 1;
+	pool.run(blocks, [&](::std::size_t block) {
+		auto output = matches.m_offsets[block];
+		const auto first = matches.block_begin(block) / 64;
+		const auto last = (matches.block_begin(block + 1) + 63) / 64;
+		for (auto word = first; word < last; ++word) {
+			for (auto bits = matches.m_bits[word]; bits != 0; bits &= bits - 1) {
+				const auto index = word * 64 + static_cast<::std::size_t>(countr_zero(bits));
+				target[output++] = source[index];
+			}
+		}
+	});
+}
+
+// Keeps the overloads that use the default pool from matching calls that pass a pool
+template <typename Type>
+using enable_without_pool_t =
+    ::std::enable_if_t<!::std::is_same_v<::std::remove_cv_t<::std::remove_reference_t<Type>>,
+                                         thread_pool>>;
+
+struct histogram_index {
+	template <typename Type>
+	XTR_NODISCARD constexpr ::std::size_t operator()(const Type &value) const noexcept {
+		return static_cast<::std::size_t>(value);
+	}
+};
+
+} // namespace detail
+
+
+// Calls function(first, last) on blocks of at least grain indices that together cover [0, count)
+template <typename Function>
+void parallel_for(thread_pool &pool, ::std::size_t count, Function &&function,
+                  ::std::size_t grain = 1) {
+	if (count == 0) {
+		return;
+	}
+	grain = grain == 0 ? 1 : grain;
+	// Extra blocks per thread balance uneven work
+	const auto most = pool.size() * 4;
+	const auto fitting = (count + grain - 1) / grain;
+	const auto blocks = fitting < most ? fitting : most;
+	pool.run(blocks, [&](::std::size_t block) {
+		function(detail::parallel_block_begin(count, blocks, block),
+		         detail::parallel_block_begin(count, blocks, block + 1));
+	});
+}
+
+template <typename Function>
+void parallel_for(::std::size_t count, Function &&function, ::std::size_t grain = 1) {
+	parallel_for(default_thread_pool(), count, ::std::forward<Function>(function), grain);
+}
+
+
+// Inclusive prefix scan of contiguous input into contiguous output of at least the same size,
+// the operation must be associative and output may be the same range as input
+template <typename Input, typename Output, typename Operation = ::std::plus<>>
+void parallel_scan(thread_pool &pool, const Input &input, Output &&output,
+                   Operation operation = Operation{}) {
+	using target_type = detail::range_value_t<Output>;
+	const auto count = static_cast<::std::size_t>(::std::size(input));
+	assert(static_cast<::std::size_t>(::std::size(output)) >= count);
+	if (count == 0) {
+		return;
+	}
+	const auto *const source = ::std::data(input);
+	auto *const target = ::std::data(output);
+	const auto blocks = detail::parallel_block_count(pool, count);
+
+	// Reduce each block, scan the block totals serially, then scan each block from its carry
+	::std::vector<target_type> totals;
+	totals.reserve(blocks);
+	for (::std::size_t block = 0; block + 1 < blocks; ++block) {
+		const auto first = detail::parallel_block_begin(count, blocks, block);
+		totals.push_back(target_type(source[first]));
+	}
+	pool.run(blocks - 1, [&](::std::size_t block) {
+		const auto first = detail::parallel_block_begin(count, blocks, block);
+		const auto last = detail::parallel_block_begin(count, blocks, block + 1);
+		totals[block] = detail::reduce_block<target_type>(source + first, last - first, operation);
+	});
+	for (::std::size_t block = 1; block < totals.size(); ++block) {
+		totals[block] = operation(totals[block - 1], totals[block]);
+	}
+	pool.run(blocks, [&](::std::size_t block) {
+		const auto first = detail::parallel_block_begin(count, blocks, block);
+		const auto last = detail::parallel_block_begin(count, blocks, block + 1);
+		detail::scan_block(source + first, target + first, last - first,
+		                   block == 0 ? nullptr : &totals[block - 1], operation);
+	});
+}
+
+template <typename Input, typename Output, typename Operation = ::std::plus<>,
+          typename = detail::enable_without_pool_t<Input>>
+void parallel_scan(const Input &input, Output &&output, Operation operation = Operation{}) {
+	parallel_scan(default_thread_pool(), input, ::std::forward<Output>(output), operation);
+}
+
+
+// Copies the elements of input that satisfy predicate into output in order and returns how many
+// were copied, predicate is called once per element from several threads, and both passes are
+// scalar loops because the predicate is an arbitrary callable
+template <typename Input, typename Output, typename Predicate>
+::std::size_t parallel_compact(thread_pool &pool, const Input &input, Output &&output,
+                               Predicate predicate) {
+	const auto count = static_cast<::std::size_t>(::std::size(input));
+	const auto *const source = ::std::data(input);
+	detail::compact_matches matches;
+	const auto total = detail::compact_offsets(pool, source, count, predicate, matches);
+	assert(static_cast<::std::size_t>(::std::size(output)) >= total);
+	detail::compact_blocks(pool, source, ::std::data(output), matches);
+	return total;
+}
+
+template <typename Input, typename Output, typename Predicate,
+          typename = detail::enable_without_pool_t<Input>>
+::std::size_t parallel_compact(const Input &input, Output &&output, Predicate predicate) {
+	return parallel_compact(default_thread_pool(), input, ::std::forward<Output>(output),
+	                        predicate);
+}
+
+// Returns the elements of input that satisfy predicate in a new vector
+template <typename Input, typename Predicate>
+XTR_NODISCARD ::std::vector<detail::range_value_t<const Input>>
+parallel_compact(thread_pool &pool, const Input &input, Predicate predicate) {
+	const auto count = static_cast<::std::size_t>(::std::size(input));
+	const auto *const source = ::std::data(input);
+	detail::compact_matches matches;
+	const auto total = detail::compact_offsets(pool, source, count, predicate, matches);
+	::std::vector<detail::range_value_t<const Input>> result(total);
+	detail::compact_blocks(pool, source, result.data(), matches);
+	return result;
+}
+
+template <typename Input, typename Predicate>
+XTR_NODISCARD ::std::vector<detail::range_value_t<const Input>>
+parallel_compact(const Input &input, Predicate predicate) {
+	return parallel_compact(default_thread_pool(), input, predicate);
+}
+
+
+// Adds to bins[projection(value)] for every value in input, each block counts into private
+// striped bins so that repeated values do not serialize on one counter
+template <typename Input, typename Bins, typename Projection = detail::histogram_index>
+void parallel_histogram(thread_pool &pool, const Input &input, Bins &&bins,
+                        Projection projection = Projection{}) {
+	using counter_type = detail::range_value_t<Bins>;
+	const auto count = static_cast<::std::size_t>(::std::size(input));
+	const auto bin_count = static_cast<::std::size_t>(::std::size(bins));
+	if (count == 0 || bin_count == 0) {
+		return;
+	}
+	const auto *const source = ::std::data(input);
+	auto *const target = ::std::data(bins);
+	const auto blocks = detail::parallel_block_count(pool, count);
+	const ::std::size_t stripes = bin_count <= 4096 ? 4 : 1;
+
+	::std::vector<::std::vector<counter_type>> locals(blocks);
+	pool.run(blocks, [&](::std::size_t block) {
+		auto &local = locals[block];
+		local.assign(bin_count * stripes, counter_type{});
+		auto index = detail::parallel_block_begin(count, blocks, block);
+		const auto last = detail::parallel_block_begin(count, blocks, block + 1);
+		auto *const counts = local.data();
+		if (stripes == 4) {
+			for (; index + 4 <= last; index += 4) {
+				const auto bin0 = projection(source[index]);
+				const auto bin1 = projection(source[index + 1]);
+				const auto bin2 = projection(source[index + 2]);
+				const auto bin3 = projection(source[index + 3]);
+				assert(bin0 < bin_count && bin1 < bin_count);
+				assert(bin2 < bin_count && bin3 < bin_count);
+				++counts[bin0];
+				++counts[bin_count + bin1];
+				++counts[bin_count * 2 + bin2];
+				++counts[bin_count * 3 + bin3];
+			}
+		}
+		for (; index < last; ++index) {
+			const auto bin = projection(source[index]);
+			assert(bin < bin_count);
+			++counts[bin];
+		}
+	});
+
+	const auto rows = blocks * stripes;
+	parallel_for(pool, bin_count, [&](::std::size_t first, ::std::size_t last) {
+		for (::std::size_t row = 0; row < rows; ++row) {
+			const auto *const counts = locals[row / stripes].data() + (row % stripes) * bin_count;
+			for (auto bin = first; bin < last; ++bin) {
+				target[bin] = static_cast<counter_type>(target[bin] + counts[bin]);
+			}
+		}
+	}, detail::parallel_grain);
+}
+
+template <typename Input, typename Bins, typename Projection = detail::histogram_index,
+          typename = detail::enable_without_pool_t<Input>>
+void parallel_histogram(const Input &input, Bins &&bins, Projection projection = Projection{}) {
+	parallel_histogram(default_thread_pool(), input, ::std::forward<Bins>(bins), projection);
+}
+
+} // namespace xtr
+
+#endif // XTR_PARALLEL
+
+
+// Parallel sorting and merging in C++
+#if defined(XTR_SORT) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+// Releases storage from ::std::allocator without destroying anything, the elements in it are
+// constructed and destroyed by hand
+template <typename Type>
+struct allocation_deleter {
+	::std::size_t m_count;
+
+	void operator()(Type *pointer) const noexcept {
+		::std::allocator<Type>{}.deallocate(pointer, m_count);
+	}
+};
+
+} // namespace detail
+
+
+// Unstable sample sort, values are scattered into one bucket per splitter interval and the
+// buckets are sorted independently, so it needs a temporary buffer as large as the input.
+// Values equal to a repeated splitter are spread over the buckets between its copies, which
+// hold nothing else and are not sorted
+template <typename Iterator, typename Compare = ::std::less<>>
+void parallel_sort(thread_pool &pool, Iterator first, Iterator last, Compare compare = Compare{}) {
+	using value_type = typename ::std::iterator_traits<Iterator>::value_type;
+	const auto count = static_cast<::std::size_t>(last - first);
+	const auto blocks = detail::parallel_block_count(pool, count);
+	if (blocks <= 1) {
+		::std::sort(first, last, compare);
+		return;
+	}
+
+	// More buckets than blocks lets threads that finish early take over the remaining buckets
+	const auto buckets = blocks * 4;
+	constexpr ::std::size_t oversampling = 16;
+	const auto sample_count = buckets * oversampling;
+	const auto stride = count / sample_count > 0 ? count / sample_count : 1;
+	::std::vector<value_type> sample;
+	sample.reserve(sample_count);
+	for (::std::size_t index = stride / 2; index < count && sample.size() < sample_count;
+	     index += stride) {
+		sample.push_back(first[static_cast<::std::ptrdiff_t>(index)]);
+	}
+	::std::sort(sample.begin(), sample.end(), compare);
+	::std::vector<value_type> splitters;
+	::std::vector<::std::size_t> run_begin;
+	splitters.reserve(buckets - 1);
+	run_begin.reserve(buckets - 1);
+	for (::std::size_t bucket = 1; bucket < buckets; ++bucket) {
+		splitters.push_back(sample[bucket * sample.size() / buckets]);
+		const auto last_splitter = splitters.size() - 1;
+		const bool tied = last_splitter > 0
+		                  && !compare(splitters[last_splitter - 1], splitters[last_splitter]);
+		run_begin.push_back(tied ? run_begin.back() : last_splitter);
+	}
+	// Bucket b holds values in [splitters[b - 1], splitters[b]), so when splitters lo to b - 1
+	// are equal the buckets lo + 1 to b - 1 are empty and take turns with b for the ties
+	const auto bucket_of = [&](const value_type &value, ::std::size_t index) {
+		const auto bucket = static_cast<::std::size_t>(
+		    ::std::upper_bound(splitters.begin(), splitters.end(), value, compare)
+		    - splitters.begin());
+		if (bucket == 0 || run_begin[bucket - 1] == bucket - 1
+		    || compare(splitters[bucket - 1], value)) {
+			return bucket;
+		}
+		const auto lowest = run_begin[bucket - 1];
+		return lowest + 1 + index % (bucket - lowest);
+	};
+
+	// Offsets are laid out bucket by bucket so every bucket ends up contiguous
+	::std::vector<::std::size_t> offsets(blocks * buckets);
+	pool.run(blocks, [&](::std::size_t block) {
+		auto *const counts = offsets.data() + block * buckets;
+		auto index = detail::parallel_block_begin(count, blocks, block);
+		const auto end = detail::parallel_block_begin(count, blocks, block + 1);
+		for (; index < end; ++index) {
+			++counts[bucket_of(first[static_cast<::std::ptrdiff_t>(index)], index)];
+		}
+	});
+	::std::vector<::std::size_t> bucket_begin(buckets + 1);
+	::std::size_t total = 0;
+	for (::std::size_t bucket = 0; bucket < buckets; ++bucket) {
+		bucket_begin[bucket] = total;
+		for (::std::size_t block = 0; block < blocks; ++block) {
+			auto &offset = offsets[block * buckets + bucket];
+			const auto size = offset;
+			offset = total;
+			total += size;
+		}
+	}
+	bucket_begin[buckets] = total;
+
+	const ::std::unique_ptr<value_type, detail::allocation_deleter<value_type>> storage{
+	    ::std::allocator<value_type>{}.allocate(count), {count}};
+	auto *const buffer = storage.get();
+	pool.run(blocks, [&](::std::size_t block) {
+		auto *const cursors = offsets.data() + block * buckets;
+		auto index = detail::parallel_block_begin(count, blocks, block);
+		const auto end = detail::parallel_block_begin(count, blocks, block + 1);
+		for (; index < end; ++index) {
+			auto &value = first[static_cast<::std::ptrdiff_t>(index)];
+			::new (static_cast<void *>(buffer + cursors[bucket_of(value, index)]++))
+			    value_type(::std::move(value));
+		}
+	});
+	pool.run(buckets, [&](::std::size_t bucket) {
+		auto *const bucket_first = buffer + bucket_begin[bucket];
+		auto *const bucket_last = buffer + bucket_begin[bucket + 1];
+		const bool ties_only = bucket > 0 && bucket + 1 < buckets
+		                       && run_begin[bucket] < bucket;
+		if (!ties_only) {
+			::std::sort(bucket_first, bucket_last, compare);
+		}
+		::std::move(bucket_first, bucket_last,
+		            first + static_cast<::std::ptrdiff_t>(bucket_begin[bucket]));
+		::std::destroy(bucket_first, bucket_last);
+	});
+}
+
+template <typename Iterator, typename Compare = ::std::less<>>
+void parallel_sort(Iterator first, Iterator last, Compare compare = Compare{}) {
+	parallel_sort(default_thread_pool(), first, last, compare);
+}
+
+
+namespace detail {
+
+template <typename Iterator>
+struct merge_cursor {
+	Iterator m_current;
+	Iterator m_end;
+};
+
+// Loser tree where each internal node keeps the loser of the match played there, so replacing
+// the winner replays only the matches on the path from its leaf to the root
+template <typename Iterator, typename Compare>
+class tournament_tree {
+	::std::vector<merge_cursor<Iterator>> m_cursors;
+	::std::vector<::std::size_t> m_tree; // Winner at index 0, leaf i is node i + size
+	Compare m_compare;
+
+public:
+	tournament_tree(::std::vector<merge_cursor<Iterator>> cursors, Compare compare) :
+	    m_cursors{::std::move(cursors)}, m_compare{compare} {
+		const auto count = m_cursors.size();
+		m_tree.assign(count > 0 ? count : 1, 0);
+		::std::vector<::std::size_t> winners(count * 2);
+		for (::std::size_t leaf = 0; leaf < count; ++leaf) {
+			winners[count + leaf] = leaf;
+		}
+		for (auto node = count - 1; node > 0 && node < count; --node) {
+			auto winner = winners[node * 2];
+			auto loser = winners[node * 2 + 1];
+			if (beats(loser, winner)) {
+				::std::swap(winner, loser);
+			}
+			winners[node] = winner;
+			m_tree[node] = loser;
+		}
+		if (count > 1) {
+			m_tree[0] = winners[1];
+		}
+	}
+
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_cursors.empty() || exhausted(m_tree[0]);
+	}
+
+	XTR_NODISCARD decltype(auto) front() const {
+		assert(!empty());
+		return *m_cursors[m_tree[0]].m_current;
+	}
+
+	void pop() {
+		assert(!empty());
+		auto winner = m_tree[0];
+		++m_cursors[winner].m_current;
+		for (auto node = (winner + m_cursors.size()) / 2; node > 0; node /= 2) {
+			if (beats(m_tree[node], winner)) {
+				::std::swap(m_tree[node], winner);
+			}
+		}
+		m_tree[0] = winner;
+	}
+
+private:
+	XTR_NODISCARD bool exhausted(::std::size_t cursor) const noexcept {
+		return m_cursors[cursor].m_current == m_cursors[cursor].m_end;
+	}
+
+	// Exhausted cursors always lose and ties go to the lower index, which keeps the merge stable
+	XTR_NODISCARD bool beats(::std::size_t left, ::std::size_t right) const {
+		if (exhausted(left)) {
+			return false;
+		}
+		if (exhausted(right)) {
+			return true;
+		}
+		const auto &left_value = *m_cursors[left].m_current;
+		const auto &right_value = *m_cursors[right].m_current;
+		if (m_compare(left_value, right_value)) {
+			return true;
+		}
+		return !m_compare(right_value, left_value) && left < right;
+	}
+};
+
+template <typename Iterator, typename OutputIterator, typename Compare>
+OutputIterator merge_cursors(::std::vector<merge_cursor<Iterator>> cursors, OutputIterator output,
+                             Compare compare) {
+	tournament_tree<Iterator, Compare> tree{::std::move(cursors), compare};
+	while (!tree.empty()) {
+		*output = tree.front();
+		++output;
+		tree.pop();
+	}
+	return output;
+}
+
+} // namespace detail
+
+
+// Stable merge of a range of sorted ranges into output, equal values keep the order of their runs
+template <typename Runs, typename OutputIterator, typename Compare = ::std::less<>>
+OutputIterator kway_merge(const Runs &runs, OutputIterator output, Compare compare = Compare{}) {
+	using iterator = decltype(::std::begin(*::std::begin(runs)));
+	::std::vector<detail::merge_cursor<iterator>> cursors;
+	for (const auto &run : runs) {
+		cursors.push_back(detail::merge_cursor<iterator>{::std::begin(run), ::std::end(run)});
+	}
+	return detail::merge_cursors(::std::move(cursors), output, compare);
+}
+
+
+#if defined(XTR_OS_POSIX)
+
+namespace detail {
+
+// Read-only memory map of a whole file that is unmapped on destruction
+class file_map {
+	void *m_address = nullptr;
+	::std::size_t m_size = 0;
+
+public:
+	file_map(int file, ::std::size_t size) : m_size{size} {
+		m_address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (m_address == MAP_FAILED) {
+			throw ::std::system_error{errno, ::std::generic_category(), "mmap"};
+		}
+		::madvise(m_address, size, MADV_SEQUENTIAL);
+	}
+
+	file_map(file_map &&other) noexcept :
+	    m_address{::std::exchange(other.m_address, nullptr)}, m_size{other.m_size} {}
+
+	file_map &operator=(file_map &&) = delete;
+
+	~file_map() {
+		if (m_address != nullptr) {
+			::munmap(m_address, m_size);
+		}
+	}
+
+
+	XTR_NODISCARD const void *data() const noexcept {
+		return m_address;
+	}
+};
+
+} // namespace detail
+
+
+// Sorts more values than fit in memory, every memory_limit bytes of pushed values are sorted and
+// spilled as a run to an unlinked temporary file, and merge() reads the runs back through mmap.
+// Every merge_fan_in runs of one size are merged into a larger run as they are spilled, so the
+// number of open files only grows with the logarithm of the number of values
+template <typename Type, typename Compare = ::std::less<>>
+class external_sorter {
+public:
+	static_assert(::std::is_trivially_copyable_v<Type>, "Type must be trivially copyable");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+
+	static constexpr size_type merge_fan_in = 16;
+
+private:
+	struct run {
+		int m_file;
+		size_type m_count;
+		size_type m_level;
+	};
+
+	::std::string m_directory;
+	::std::vector<Type> m_buffer;
+	::std::vector<run> m_runs;
+	size_type m_run_size;
+	size_type m_size = 0;
+	Compare m_compare;
+	thread_pool *m_pool;
+
+public:
+	explicit external_sorter(::std::string directory, size_type memory_limit = size_type{1} << 28,
+	                         Compare compare = Compare{},
+	                         thread_pool &pool = default_thread_pool()) :
+	    m_directory{::std::move(directory)},
+	    m_run_size{memory_limit / sizeof(Type) > 0 ? memory_limit / sizeof(Type) : 1},
+	    m_compare{compare}, m_pool{&pool} {}
+
+	external_sorter(const external_sorter &) = delete;
+	external_sorter &operator=(const external_sorter &) = delete;
+
+	~external_sorter() {
+		clear();
+	}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	void push(const Type &value) {
+		if (m_buffer.size() == m_run_size) {
+			spill();
+		}
+		if (m_buffer.capacity() == 0) {
+			m_buffer.reserve(m_run_size);
+		}
+		m_buffer.push_back(value);
+		++m_size;
+	}
+
+	// Writes every value in sorted order to output and leaves the sorter empty
+	template <typename OutputIterator>
+	OutputIterator merge(OutputIterator output) {
+		parallel_sort(*m_pool, m_buffer.begin(), m_buffer.end(), m_compare);
+		::std::vector<detail::file_map> maps;
+		::std::vector<detail::merge_cursor<const Type *>> cursors;
+		maps.reserve(m_runs.size());
+		for (const auto &spilled : m_runs) {
+			maps.emplace_back(spilled.m_file, spilled.m_count * sizeof(Type));
+			const auto *const values = static_cast<const Type *>(maps.back().data());
+			cursors.push_back({values, values + spilled.m_count});
+		}
+		cursors.push_back({m_buffer.data(), m_buffer.data() + m_buffer.size()});
+		output = detail::merge_cursors(::std::move(cursors), output, m_compare);
+		maps.clear();
+		clear();
+		return output;
+	}
+
+	void clear() noexcept {
+		for (const auto &spilled : m_runs) {
+			::close(spilled.m_file);
+		}
+		m_runs.clear();
+		m_buffer.clear();
+		m_size = 0;
+	}
+
+private:
+	void spill() {
+		parallel_sort(*m_pool, m_buffer.begin(), m_buffer.end(), m_compare);
+		add_run(0);
+		write_values(m_runs.back().m_file, m_buffer.data(), m_buffer.size());
+		m_runs.back().m_count = m_buffer.size();
+		m_buffer.clear();
+		// Levels never increase along m_runs, so the last run and the one merge_fan_in before it
+		// share a level only when every run between them does
+		while (m_runs.size() >= merge_fan_in
+		       && m_runs[m_runs.size() - merge_fan_in].m_level == m_runs.back().m_level) {
+			merge_last_runs();
+		}
+	}
+
+	// Merges the last merge_fan_in runs into one run of the next level, using m_buffer to batch
+	// the writes
+	void merge_last_runs() {
+		const auto first_run = m_runs.size() - merge_fan_in;
+		add_run(m_runs.back().m_level + 1);
+		auto &merged = m_runs.back();
+		{
+			::std::vector<detail::file_map> maps;
+			::std::vector<detail::merge_cursor<const Type *>> cursors;
+			maps.reserve(merge_fan_in);
+			for (auto index = first_run; index < first_run + merge_fan_in; ++index) {
+				const auto &spilled = m_runs[index];
+				maps.emplace_back(spilled.m_file, spilled.m_count * sizeof(Type));
+				const auto *const values = static_cast<const Type *>(maps.back().data());
+				cursors.push_back({values, values + spilled.m_count});
+			}
+			detail::tournament_tree<const Type *, Compare> tree{::std::move(cursors), m_compare};
+			while (!tree.empty()) {
+				m_buffer.push_back(tree.front());
+				tree.pop();
+				if (m_buffer.size() == m_run_size || tree.empty()) {
+					write_values(merged.m_file, m_buffer.data(), m_buffer.size());
+					merged.m_count += m_buffer.size();
+					m_buffer.clear();
+				}
+			}
+		}
+		for (auto index = first_run; index < first_run + merge_fan_in; ++index) {
+			::close(m_runs[index].m_file);
+		}
+		m_runs.erase(m_runs.begin() + static_cast<::std::ptrdiff_t>(first_run),
+		             m_runs.end() - 1);
+	}
+
+	// Appends an empty run backed by a new temporary file, which the system deletes once it is
+	// closed
+	void add_run(size_type level) {
+		m_runs.reserve(m_runs.size() + 1);
+		auto path = m_directory + "/xtr-run-XXXXXX";
+		const int file = ::mkstemp(path.data());
+		if (file < 0) {
+			throw ::std::system_error{errno, ::std::generic_category(), "mkstemp"};
+		}
+		::unlink(path.c_str());
+		m_runs.push_back(run{file, 0, level});
+	}
+
+	static void write_values(int file, const Type *values, size_type count) {
+		const auto *data = reinterpret_cast<const char *>(values);
+		auto remaining = count * sizeof(Type);
+		while (remaining > 0) {
+			const auto written = ::write(file, data, remaining);
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw ::std::system_error{errno, ::std::generic_category(), "write"};
+			}
+			data += written;
+			remaining -= static_cast<::std::size_t>(written);
+		}
+	}
+};
+
+#endif // XTR_OS_POSIX
+
+} // namespace xtr
+
+#endif // XTR_SORT
+
+
+// Index search functions in C++
+#if defined(XTR_SEARCH) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+template <typename Range, typename = void>
+struct contiguous_value {
+	using type = void;
+};
+
+template <typename Range>
+struct contiguous_value<Range, ::std::void_t<decltype(::std::data(::std::declval<Range &>()))>> {
+	using type = ::std::remove_cv_t<
+	    ::std::remove_pointer_t<decltype(::std::data(::std::declval<Range &>()))>>;
+};
+
+// Element type of ranges with contiguous storage, void for other ranges
+template <typename Range>
+using contiguous_value_t = typename contiguous_value<::std::remove_reference_t<Range>>::type;
+
+template <typename Compare, typename Type>
+inline constexpr bool is_less_v =
+    ::std::is_same_v<Compare, ::std::less<>> || ::std::is_same_v<Compare, ::std::less<Type>>;
+
+#if defined(XTR_SIMD_SSE2)
+
+// Each search kernel keeps one candidate per lane and the index it came from in a parallel
+// register, then reduces the lanes with scalar comparisons that prefer the lower index
+template <typename Type>
+struct simd_search_traits {
+	static constexpr bool supported = false;
+};
+
+template <>
+struct simd_search_traits<float> {
+	static constexpr bool supported = true;
+	static constexpr ::std::size_t lanes = 4;
+	using vector = __m128;
+
+	static vector load(const float *values) noexcept {
+		return _mm_loadu_ps(values);
+	}
+
+	static __m128i less(vector left, vector right) noexcept {
+		return _mm_castps_si128(_mm_cmplt_ps(left, right));
+	}
+
+	static vector select(__m128i mask, vector left, vector right) noexcept {
+		const auto selector = _mm_castsi128_ps(mask);
+		return _mm_or_ps(_mm_and_ps(selector, left), _mm_andnot_ps(selector, right));
+	}
+};
+
+template <>
+struct simd_search_traits<double> {
+	static constexpr bool supported = true;
+	static constexpr ::std::size_t lanes = 2;
+	using vector = __m128d;
+
+	static vector load(const double *values) noexcept {
+		return _mm_loadu_pd(values);
+	}
+
+	static __m128i less(vector left, vector right) noexcept {
+		return _mm_castpd_si128(_mm_cmplt_pd(left, right));
+	}
+
+	static vector select(__m128i mask, vector left, vector right) noexcept {
+		const auto selector = _mm_castsi128_pd(mask);
+		return _mm_or_pd(_mm_and_pd(selector, left), _mm_andnot_pd(selector, right));
+	}
+};
+
+template <>
+struct simd_search_traits<::std::int32_t> {
+	static constexpr bool supported = true;
+	static constexpr ::std::size_t lanes = 4;
+	using vector = __m128i;
+
+	static vector load(const ::std::int32_t *values) noexcept {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+	}
+
+	static __m128i less(vector left, vector right) noexcept {
+		return _mm_cmplt_epi32(left, right);
+	}
+
+	static vector select(__m128i mask, vector left, vector right) noexcept {
+		return _mm_or_si128(_mm_and_si128(mask, left), _mm_andnot_si128(mask, right));
+	}
+};
+
+// Unsigned lanes are biased into signed order because SSE2 only compares signed integers
+template <>
+struct simd_search_traits<::std::uint32_t> : simd_search_traits<::std::int32_t> {
+	static vector load(const ::std::uint32_t *values) noexcept {
+		return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values)),
+		                     _mm_set1_epi32(static_cast<int>(0x80000000u)));
+	}
+};
+
+// Index lanes are 32 bits wide for four lanes, so longer inputs are searched in pieces
+inline constexpr ::std::size_t simd_search_piece = ::std::size_t{1} << 30;
+
+template <bool Maximum, typename Type>
+XTR_NODISCARD ::std::size_t simd_search_extreme_piece(const Type *values,
+                                                      ::std::size_t count) noexcept {
+	using traits = simd_search_traits<Type>;
+	constexpr auto lanes = traits::lanes;
+	const auto better = [](const Type &candidate, const Type &best) {
+		return Maximum ? best < candidate : candidate < best;
+	};
+
+	::std::size_t result = 0;
+	::std::size_t position = 0;
+	if (count >= lanes * 2) {
+		auto best = traits::load(values);
+		__m128i best_index;
+		__m128i index;
+		__m128i step;
+		if constexpr (lanes == 4) {
+			best_index = _mm_setr_epi32(0, 1, 2, 3);
+			step = _mm_set1_epi32(4);
+		}
+		else {
+			best_index = _mm_set_epi64x(1, 0);
+			step = _mm_set1_epi64x(2);
+		}
+		index = best_index;
+		for (position = lanes; position + lanes <= count; position += lanes) {
+			index = lanes == 4 ? _mm_add_epi32(index, step) : _mm_add_epi64(index, step);
+			const auto value = traits::load(values + position);
+			const auto mask = Maximum ? traits::less(best, value) : traits::less(value, best);
+			best = traits::select(mask, value, best);
+			best_index =
+			    _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, best_index));
+		}
+
+		using index_lane = ::std::conditional_t<lanes == 4, ::std::uint32_t, ::std::uint64_t>;
+		alignas(16) index_lane indexes[lanes];
+		_mm_store_si128(reinterpret_cast<__m128i *>(indexes), best_index);
+		result = static_cast<::std::size_t>(indexes[0]);
+		for (::std::size_t lane = 1; lane < lanes; ++lane) {
+			const auto candidate = static_cast<::std::size_t>(indexes[lane]);
+			if (better(values[candidate], values[result])
+			    || (!better(values[result], values[candidate]) && candidate < result)) {
+				result = candidate;
+			}
+		}
+	}
+	for (; position < count; ++position) {
+		if (better(values[position], values[result])) {
+			result = position;
+		}
+	}
+	return result;
+}
+
+template <bool Maximum, typename Type>
+XTR_NODISCARD ::std::size_t simd_search_extreme(const Type *values, ::std::size_t count) noexcept {
+	::std::size_t result = 0;
+	for (::std::size_t first = 0; first < count; first += simd_search_piece) {
+		const auto size = count - first < simd_search_piece ? count - first : simd_search_piece;
+		const auto candidate = first + simd_search_extreme_piece<Maximum>(values + first, size);
+		if (first == 0 || (Maximum ? values[result] < values[candidate]
+		                           : values[candidate] < values[result])) {
+			result = candidate;
+		}
+	}
+	return result;
+}
+
+// Equality compares whole elements, 64-bit integers need both 32-bit halves to match
+template <typename Type>
+XTR_NODISCARD int simd_equal_mask(const Type *values, __m128i needle) noexcept {
+	if constexpr (::std::is_same_v<Type, float>) {
+		return _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values), _mm_castsi128_ps(needle)));
+	}
+	else if constexpr (::std::is_same_v<Type, double>) {
+		return _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(values), _mm_castsi128_pd(needle)));
+	}
+	else {
+		const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+		if constexpr (sizeof(Type) == 1) {
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(value, needle));
+		}
+		else if constexpr (sizeof(Type) == 2) {
+			return _mm_movemask_epi8(_mm_cmpeq_epi16(value, needle));
+		}
+		else if constexpr (sizeof(Type) == 4) {
+			return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(value, needle)));
+		}
+		else {
+			const auto halves = _mm_cmpeq_epi32(value, needle);
+			const auto both = _mm_and_si128(halves, _mm_shuffle_epi32(halves, 0xB1));
+			return _mm_movemask_pd(_mm_castsi128_pd(both));
+		}
+	}
+}
+
+template <typename Type>
+XTR_NODISCARD __m128i simd_broadcast_needle(Type value) noexcept {
+	alignas(16) Type lanes[16 / sizeof(Type)];
+	for (auto &lane : lanes) {
+		lane = value;
+	}
+	return _mm_load_si128(reinterpret_cast<const __m128i *>(lanes));
+}
+
+template <typename Type>
+XTR_NODISCARD ::std::size_t simd_find(const Type *values, ::std::size_t count,
+                                      Type value) noexcept {
+	constexpr ::std::size_t lanes = 16 / sizeof(Type);
+	// Bytes per mask bit, 8 and 16-bit elements use the byte mask
+	constexpr ::std::size_t bit_elements = sizeof(Type) == 2 ? 2 : 1;
+	const auto needle = simd_broadcast_needle(value);
+	::std::size_t position = 0;
+	for (; position + lanes <= count; position += lanes) {
+		const auto mask = simd_equal_mask(values + position, needle);
+		if (mask != 0) {
+			const auto first = countr_zero(static_cast<::std::uint64_t>(mask));
+			return position + static_cast<::std::size_t>(first) / bit_elements;
+		}
+	}
+	for (; position < count; ++position) {
+		if (values[position] == value) {
+			break;
+		}
+	}
+	return position;
+}
+
+template <typename Type>
+inline constexpr bool is_simd_find_v =
+    (::std::is_integral_v<Type> && !::std::is_same_v<Type, bool>)
+    || ::std::is_same_v<Type, float> || ::std::is_same_v<Type, double>;
+
+#endif // XTR_SIMD_SSE2
+
+template <bool Maximum, typename Range, typename Compare>
+XTR_NODISCARD get_index_t<Range> search_extreme(Range &range, Compare &compare) {
+	using index_type = get_index_t<Range>;
+#if defined(XTR_SIMD_SSE2)
+	using value_type = contiguous_value_t<Range>;
+	if constexpr (is_less_v<Compare, value_type> && simd_search_traits<value_type>::supported) {
+		const auto count = static_cast<::std::size_t>(::std::size(range));
+		return static_cast<index_type>(simd_search_extreme<Maximum>(::std::data(range), count));
+	}
+	else
+#endif
+	{
+		using ::std::begin;
+		using ::std::end;
+		auto first = begin(range);
+		const auto last = end(range);
+		index_type index{};
+		index_type result{};
+		if (first == last) {
+			return result;
+		}
+		auto best = first;
+		for (++first, ++index; first != last; ++first, ++index) {
+			if (Maximum ? compare(*best, *first) : compare(*first, *best)) {
+				best = first;
+				result = index;
+			}
+		}
+		return result;
+	}
+}
+
+} // namespace detail
+
+
+// Index of the first smallest element, or zero for an empty range, ranges of float containing NaN
+// give an unspecified index
+template <typename Range, typename Compare = ::std::less<>>
+XTR_NODISCARD detail::get_index_t<Range> argmin(Range &&range, Compare compare = Compare{}) {
+	return detail::search_extreme<false>(range, compare);
+}
+
+// Index of the first largest element, or zero for an empty range
+template <typename Range, typename Compare = ::std::less<>>
+XTR_NODISCARD detail::get_index_t<Range> argmax(Range &&range, Compare compare = Compare{}) {
+	return detail::search_extreme<true>(range, compare);
+}
+
+// Index of the first element equal to or satisfying needle, or the size of the range if none does
+template <typename Range, typename Needle>
+XTR_NODISCARD detail::get_index_t<Range> find_index(Range &&range, const Needle &needle) {
+	using index_type = detail::get_index_t<Range>;
+	using ::std::begin;
+	using ::std::end;
+#if defined(XTR_SIMD_SSE2)
+	using value_type = detail::contiguous_value_t<Range>;
+	if constexpr (::std::is_same_v<Needle, value_type> && detail::is_simd_find_v<value_type>) {
+		const auto count = static_cast<::std::size_t>(::std::size(range));
+		return static_cast<index_type>(detail::simd_find(::std::data(range), count, needle));
+	}
+	else
+#endif
+	{
+		index_type index{};
+		const auto last = end(range);
+		for (auto first = begin(range); first != last; ++first, ++index) {
+			if constexpr (::std::is_invocable_r_v<bool, const Needle &, decltype(*first)>) {
+				if (needle(*first)) {
+					break;
+				}
+			}
+			else {
+				if (*first == needle) {
+					break;
+				}
+			}
+		}
+		return index;
+	}
+}
+
+} // namespace xtr
+
+#endif // XTR_SEARCH
+
+
+// Copy and fill with non-temporal stores in C++
+#if defined(XTR_STREAM) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+// Smaller buffers likely fit in cache and are about to be read, so regular stores are faster
+inline constexpr ::std::size_t stream_threshold = ::std::size_t{1} << 18;
+
+// Streaming whole cache lines lets the write combining buffers flush without reading memory
+inline constexpr ::std::size_t stream_alignment = 64;
+
+template <typename Type>
+struct stream_identity {
+	using type = Type;
+};
+
+#if defined(XTR_SIMD_SSE2)
+
+XTR_NODISCARD inline ::std::size_t stream_head(const void *destination) noexcept {
+	if (is_aligned(destination, stream_alignment)) {
+		return 0;
+	}
+	const auto address = reinterpret_cast<::std::uintptr_t>(destination);
+	return stream_alignment - static_cast<::std::size_t>(address % stream_alignment);
+}
+
+// Stores whole cache lines of pattern starting at an aligned destination
+inline void stream_lines(unsigned char *destination, __m128i pattern,
+                         ::std::size_t lines) noexcept {
+	assert(is_aligned(destination, stream_alignment));
+	auto *target = reinterpret_cast<__m128i *>(destination);
+	for (; lines > 0; --lines, target += 4) {
+		_mm_stream_si128(target, pattern);
+		_mm_stream_si128(target + 1, pattern);
+		_mm_stream_si128(target + 2, pattern);
+		_mm_stream_si128(target + 3, pattern);
+	}
+	_mm_sfence();
+}
+
+#endif // XTR_SIMD_SSE2
+
+} // namespace detail
+
+
+// Copy that bypasses the cache for large buffers so it does not evict the working set, the
+// destination is aligned with regular stores first and the ranges must not overlap
+inline void stream_copy(void *destination, const void *source, ::std::size_t bytes) noexcept {
+#if defined(XTR_SIMD_SSE2)
+	if (bytes >= detail::stream_threshold) {
+		auto *target = static_cast<unsigned char *>(destination);
+		const auto *origin = static_cast<const unsigned char *>(source);
+		const auto head = detail::stream_head(target);
+		::std::memcpy(target, origin, head);
+		target += head;
+		origin += head;
+		bytes -= head;
+
+		for (; bytes >= detail::stream_alignment; bytes -= detail::stream_alignment) {
+			const auto *input = reinterpret_cast<const __m128i *>(origin);
+			auto *output = reinterpret_cast<__m128i *>(target);
+			const auto first = _mm_loadu_si128(input);
+			const auto second = _mm_loadu_si128(input + 1);
+			const auto third = _mm_loadu_si128(input + 2);
+			const auto fourth = _mm_loadu_si128(input + 3);
+			_mm_stream_si128(output, first);
+			_mm_stream_si128(output + 1, second);
+			_mm_stream_si128(output + 2, third);
+			_mm_stream_si128(output + 3, fourth);
+			target += detail::stream_alignment;
+			origin += detail::stream_alignment;
+		}
+		// Orders the streaming stores before any later store that could publish the buffer
+		_mm_sfence();
+		::std::memcpy(target, origin, bytes);
+		return;
+	}
+#endif
+	::std::memcpy(destination, source, bytes);
+}
+
+// Fills count elements with value, streaming when the type is a power of two up to 16 bytes and
+// the destination is aligned to its size
+template <typename Type>
+void stream_fill(Type *destination, const typename detail::stream_identity<Type>::type &value,
+                 ::std::size_t count) noexcept {
+	static_assert(::std::is_trivially_copyable_v<Type>, "Type must be trivially copyable");
+#if defined(XTR_SIMD_SSE2)
+	constexpr bool is_pattern = sizeof(Type) <= 16 && 16 % sizeof(Type) == 0;
+	if constexpr (is_pattern) {
+		if (count * sizeof(Type) >= detail::stream_threshold
+		    && is_aligned(destination, sizeof(Type))) {
+			const auto head = detail::stream_head(destination) / sizeof(Type);
+			::std::fill_n(destination, head, value);
+			destination += head;
+			count -= head;
+
+			alignas(16) Type lanes[16 / sizeof(Type)];
+			for (auto &lane : lanes) {
+				lane = value;
+			}
+			constexpr auto line_elements = detail::stream_alignment / sizeof(Type);
+			const auto lines = count / line_elements;
+			detail::stream_lines(reinterpret_cast<unsigned char *>(destination),
+			                     _mm_load_si128(reinterpret_cast<const __m128i *>(lanes)), lines);
+			destination += lines * line_elements;
+			count -= lines * line_elements;
+		}
+	}
+#endif
+	::std::fill_n(destination, count, value);
+}
+
+// Fills bytes of raw memory with value like std::memset
+inline void stream_fill(void *destination, unsigned char value, ::std::size_t bytes) noexcept {
+	stream_fill(static_cast<unsigned char *>(destination), value, bytes);
+}
+
+} // namespace xtr
+
+#endif // XTR_STREAM
+
+
+// Buffered reader of fixed size records in C++
+#if defined(XTR_RECORD_READER) && defined(__cplusplus) && defined(XTR_OS_POSIX)
+
+namespace xtr {
+
+template <typename Type>
+class record_reader;
+
+struct record_reader_options {
+	// Rounded down to whole records, every read fills one chunk
+	::std::size_t chunk_bytes = ::std::size_t{4} << 20;
+	// Reads the next chunk on a helper thread while the current one is processed
+	bool read_ahead = true;
+	// Tells the kernel the file is read sequentially so it reads ahead further
+	bool sequential = true;
+};
+
+
+namespace detail {
+
+// Closes a file descriptor on destruction, negative descriptors are ignored
+class unique_file {
+	int m_file;
+
+public:
+	explicit unique_file(int file) noexcept : m_file{file} {}
+
+	unique_file(const unique_file &) = delete;
+	unique_file &operator=(const unique_file &) = delete;
+
+	~unique_file() {
+		if (m_file >= 0) {
+			::close(m_file);
+		}
+	}
+
+
+	XTR_NODISCARD int get() const noexcept {
+		return m_file;
+	}
+};
+
+// Frees memory from the aligned operator new
+template <::std::size_t Alignment>
+struct aligned_delete {
+	void operator()(void *pointer) const noexcept {
+		::operator delete(pointer, ::std::align_val_t{Alignment});
+	}
+};
+
+template <typename Type>
+class record_reader_iterator {
+public:
+	using iterator_category = ::std::input_iterator_tag;
+	using value_type = Type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = const Type *;
+	using reference = const Type &;
+
+	record_reader<Type> *m_reader = nullptr;
+	const Type *m_current = nullptr;
+	const Type *m_end = nullptr;
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return *m_current;
+	}
+
+	XTR_NODISCARD pointer operator->() const noexcept {
+		return m_current;
+	}
+
+	record_reader_iterator &operator++() {
+		if (++m_current == m_end) {
+			m_reader->next_chunk(*this);
+		}
+		return *this;
+	}
+
+	XTR_NODISCARD friend bool operator==(const record_reader_iterator &left,
+	                                     const record_reader_iterator &right) noexcept {
+		return left.m_current == right.m_current;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const record_reader_iterator &left,
+	                                     const record_reader_iterator &right) noexcept {
+		return left.m_current != right.m_current;
+	}
+};
+
+} // namespace detail
+
+
+// Single pass reader of a file of trivially copyable records, records are read in page aligned
+// chunks of several megabytes and referenced in place, so iterating does not copy them
+template <typename Type>
+class record_reader {
+public:
+	static_assert(::std::is_trivially_copyable_v<Type>, "Type must be trivially copyable");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using iterator = detail::record_reader_iterator<Type>;
+	using const_iterator = iterator;
+
+	friend iterator;
+
+private:
+	static constexpr ::std::size_t buffer_alignment = 4096;
+
+	struct chunk {
+		::std::unique_ptr<Type[], detail::aligned_delete<buffer_alignment>> m_records;
+		size_type m_count = 0;
+		int m_error = 0;
+		bool m_filled = false;
+	};
+
+	chunk m_chunks[2];
+	size_type m_chunk_records;
+	detail::unique_file m_file;
+	size_type m_size = 0;
+	size_type m_consumer = 0;
+	bool m_read_ahead;
+	bool m_started = false;
+	bool m_stop = false;
+	::std::mutex m_mutex;
+	::std::condition_variable m_changed;
+	::std::thread m_thread;
+
+public:
+	explicit record_reader(const ::std::string &path,
+	                       const record_reader_options &options = record_reader_options{}) :
+	    m_chunk_records{options.chunk_bytes / sizeof(Type) > 0 ? options.chunk_bytes / sizeof(Type)
+	                                                            : 1},
+	    m_file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)},
+	    m_read_ahead{options.read_ahead} {
+		if (m_file.get() < 0) {
+			throw ::std::system_error{errno, ::std::generic_category(), path};
+		}
+		struct stat status;
+		if (::fstat(m_file.get(), &status) == 0) {
+			m_size = static_cast<size_type>(status.st_size) / sizeof(Type);
+		}
+#if defined(POSIX_FADV_SEQUENTIAL)
+		if (options.sequential) {
+			::posix_fadvise(m_file.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+		}
+#endif
+		// The members free the buffers and close the file if anything below throws
+		const auto buffers = m_read_ahead ? 2 : 1;
+		for (int index = 0; index < buffers; ++index) {
+			m_chunks[index].m_records.reset(static_cast<Type *>(::operator new(
+			    m_chunk_records * sizeof(Type), ::std::align_val_t{buffer_alignment})));
+		}
+		if (m_read_ahead) {
+			m_thread = ::std::thread{[this] { read_ahead(); }};
+		}
+	}
+
+	record_reader(const record_reader &) = delete;
+	record_reader &operator=(const record_reader &) = delete;
+
+	~record_reader() {
+		if (m_thread.joinable()) {
+			{
+				::std::lock_guard<::std::mutex> lock{m_mutex};
+				m_stop = true;
+			}
+			m_changed.notify_all();
+			m_thread.join();
+		}
+	}
+
+
+	// Number of whole records in the file when it was opened
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	// Starts the only pass over the records
+	XTR_NODISCARD iterator begin() {
+		assert(!m_started && "record_reader can only be iterated once");
+		iterator result;
+		result.m_reader = this;
+		next_chunk(result);
+		return result;
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return iterator{};
+	}
+
+private:
+	// Fills records with whole records and returns how many, a short count means end of file
+	XTR_NODISCARD size_type read_chunk(Type *records, int &error) noexcept {
+		auto *data = reinterpret_cast<char *>(records);
+		const auto capacity = m_chunk_records * sizeof(Type);
+		size_type total = 0;
+		while (total < capacity) {
+			const auto result = ::read(m_file.get(), data + total, capacity - total);
+			if (result < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				error = errno;
+				break;
+			}
+			if (result == 0) {
+				break;
+			}
+			total += static_cast<size_type>(result);
+		}
+		return total / sizeof(Type);
+	}
+
+	void read_ahead() noexcept {
+		for (size_type slot = 0;; slot ^= 1) {
+			{
+				::std::unique_lock<::std::mutex> lock{m_mutex};
+				m_changed.wait(lock, [&] { return m_stop || !m_chunks[slot].m_filled; });
+				if (m_stop) {
+					return;
+				}
+			}
+			int error = 0;
+			const auto count = read_chunk(m_chunks[slot].m_records.get(), error);
+			{
+				::std::lock_guard<::std::mutex> lock{m_mutex};
+				m_chunks[slot].m_count = count;
+				m_chunks[slot].m_error = error;
+				m_chunks[slot].m_filled = true;
+			}
+			m_changed.notify_all();
+			if (count < m_chunk_records) {
+				return;
+			}
+		}
+	}
+
+	// Points the iterator at the next chunk, or at the end once the last chunk has been used
+	void next_chunk(iterator &position) {
+		position.m_current = nullptr;
+		position.m_end = nullptr;
+		chunk *current;
+		if (m_read_ahead) {
+			::std::unique_lock<::std::mutex> lock{m_mutex};
+			if (m_started) {
+				if (m_chunks[m_consumer].m_count < m_chunk_records) {
+					return;
+				}
+				m_chunks[m_consumer].m_filled = false;
+				m_consumer ^= 1;
+				m_changed.notify_all();
+			}
+			m_changed.wait(lock, [&] { return m_chunks[m_consumer].m_filled; });
+			current = &m_chunks[m_consumer];
+		}
+		else {
+			current = &m_chunks[0];
+			if (m_started && current->m_count < m_chunk_records) {
+				return;
+			}
+			current->m_count = read_chunk(current->m_records.get(), current->m_error);
+		}
+		m_started = true;
+		if (current->m_error != 0) {
+			throw ::std::system_error{current->m_error, ::std::generic_category(), "read"};
+		}
+		if (current->m_count > 0) {
+			position.m_current = current->m_records.get();
+			position.m_end = position.m_current + current->m_count;
+		}
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_RECORD_READER
+
+
+// LZ4 block compression in C++
+#if defined(XTR_COMPRESSION) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+inline constexpr int lz4_hash_bits = 12;
+inline constexpr ::std::size_t lz4_min_match = 4;
+// A match must start this many bytes before the end and the last 5 bytes are always literals
+inline constexpr ::std::size_t lz4_match_start_limit = 12;
+inline constexpr ::std::size_t lz4_last_literals = 5;
+inline constexpr ::std::size_t lz4_max_offset = 65535;
+
+XTR_NODISCARD inline ::std::uint32_t lz4_read32(const unsigned char *source) noexcept {
+	::std::uint32_t result;
+	::std::memcpy(&result, source, sizeof(result));
+	return result;
+}
+
+XTR_NODISCARD inline ::std::uint64_t lz4_read64(const unsigned char *source) noexcept {
+	::std::uint64_t result;
+	::std::memcpy(&result, source, sizeof(result));
+	return result;
+}
+
+XTR_NODISCARD inline ::std::uint32_t lz4_hash(::std::uint32_t sequence) noexcept {
+	return (sequence * 2654435761u) >> (32 - lz4_hash_bits);
+}
+
+// Writes the remainder of a length that did not fit in its 4-bit token field
+inline unsigned char *lz4_write_length(unsigned char *output, ::std::size_t length) noexcept {
+	for (; length >= 255; length -= 255) {
+		*output++ = 255;
+	}
+	*output++ = static_cast<unsigned char>(length);
+	return output;
+}
+
+XTR_NODISCARD inline bool lz4_read_length(const unsigned char *&input, const unsigned char *end,
+                                          ::std::size_t &length) noexcept {
+	unsigned char byte;
+	do {
+		if (input == end) {
+			return false;
+		}
+		byte = *input++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+// Copies in 16 byte steps and may write up to 15 bytes past the end of the destination
+inline void lz4_wild_copy(unsigned char *destination, const unsigned char *source,
+                          ::std::size_t length) noexcept {
+	const auto *const end = destination + length;
+	do {
+		::std::memcpy(destination, source, 16);
+		destination += 16;
+		source += 16;
+	} while (destination < end);
+}
+
+} // namespace detail
+
+
+// Largest compressed size of size bytes of input, for sizing destination buffers
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::size_t lz4_compress_bound(::std::size_t size) noexcept {
+	return size + size / 255 + 16;
+}
+
+// Compresses into the LZ4 block format and returns the compressed size, or nothing when the
+// destination is too small, a capacity of lz4_compress_bound(size) always suffices
+XTR_NODISCARD inline ::std::optional<::std::size_t>
+lz4_compress(const void *source, ::std::size_t size, void *destination,
+             ::std::size_t capacity) noexcept {
+	const auto *const base = static_cast<const unsigned char *>(source);
+	const auto *const input_end = base + size;
+	const auto *input = base;
+	const auto *anchor = base;
+	auto *const output_begin = static_cast<unsigned char *>(destination);
+	auto *const output_end = output_begin + capacity;
+	auto *output = output_begin;
+
+	if (size > detail::lz4_match_start_limit) {
+		::std::uint32_t table[::std::size_t{1} << detail::lz4_hash_bits] = {};
+		const auto *const match_start_limit = input_end - detail::lz4_match_start_limit;
+		const auto *const match_end_limit = input_end - detail::lz4_last_literals;
+		++input;
+		while (input < match_start_limit) {
+			const auto sequence = detail::lz4_read32(input);
+			auto &slot = table[detail::lz4_hash(sequence)];
+			const auto *reference = base + slot;
+			slot = static_cast<::std::uint32_t>(input - base);
+			if (static_cast<::std::size_t>(input - reference) > detail::lz4_max_offset
+			    || detail::lz4_read32(reference) != sequence) {
+				// Incompressible input is skipped faster the longer no match has been found
+				input += 1 + ((input - anchor) >> 6);
+				continue;
+			}
+
+			while (input > anchor && reference > base && input[-1] == reference[-1]) {
+				--input;
+				--reference;
+			}
+			const auto *match_end = input + detail::lz4_min_match;
+			const auto *reference_end = reference + detail::lz4_min_match;
+			while (match_end + 8 <= match_end_limit
+			       && detail::lz4_read64(match_end) == detail::lz4_read64(reference_end)) {
+				match_end += 8;
+				reference_end += 8;
+			}
+			while (match_end < match_end_limit && *match_end == *reference_end) {
+				++match_end;
+				++reference_end;
+			}
+
+			const auto literals = static_cast<::std::size_t>(input - anchor);
+			const auto match =
+			    static_cast<::std::size_t>(match_end - input) - detail::lz4_min_match;
+			if (static_cast<::std::size_t>(output_end - output)
+			    < literals + literals / 255 + match / 255 + 5) {
+				return ::std::nullopt;
+			}
+			auto *const token = output++;
+			*token = static_cast<unsigned char>((literals < 15 ? literals : 15) << 4);
+			if (literals >= 15) {
+				output = detail::lz4_write_length(output, literals - 15);
+			}
+			::std::memcpy(output, anchor, literals);
+			output += literals;
+			const auto offset = static_cast<::std::size_t>(input - reference);
+			*output++ = static_cast<unsigned char>(offset);
+			*output++ = static_cast<unsigned char>(offset >> 8);
+			*token |= static_cast<unsigned char>(match < 15 ? match : 15);
+			if (match >= 15) {
+				output = detail::lz4_write_length(output, match - 15);
+			}
+
+			input = match_end;
+			anchor = input;
+			if (input < match_start_limit) {
+				table[detail::lz4_hash(detail::lz4_read32(input - 2))] =
+				    static_cast<::std::uint32_t>(input - 2 - base);
+			}
+		}
+	}
+
+	const auto literals = static_cast<::std::size_t>(input_end - anchor);
+	if (static_cast<::std::size_t>(output_end - output) < literals + literals / 255 + 2) {
+		return ::std::nullopt;
+	}
+	*output++ = static_cast<unsigned char>((literals < 15 ? literals : 15) << 4);
+	if (literals >= 15) {
+		output = detail::lz4_write_length(output, literals - 15);
+	}
+	if (literals > 0) {
+		::std::memcpy(output, anchor, literals);
+	}
+	output += literals;
+	return static_cast<::std::size_t>(output - output_begin);
+}
+
+// Decompresses an LZ4 block and returns the decompressed size, or nothing when the block is
+// malformed or does not fit in capacity, never reads or writes outside either buffer
+XTR_NODISCARD inline ::std::optional<::std::size_t>
+lz4_decompress(const void *source, ::std::size_t size, void *destination,
+               ::std::size_t capacity) noexcept {
+	const auto *input = static_cast<const unsigned char *>(source);
+	const auto *const input_end = input + size;
+	auto *const output_begin = static_cast<unsigned char *>(destination);
+	auto *const output_end = output_begin + capacity;
+	auto *output = output_begin;
+
+	for (;;) {
+		if (input == input_end) {
+			return ::std::nullopt;
+		}
+		const unsigned token = *input++;
+
+		::std::size_t literals = token >> 4;
+		if (literals == 15 && !detail::lz4_read_length(input, input_end, literals)) {
+			return ::std::nullopt;
+		}
+		const auto input_left = static_cast<::std::size_t>(input_end - input);
+		const auto output_left = static_cast<::std::size_t>(output_end - output);
+		if (literals > input_left || literals > output_left) {
+			return ::std::nullopt;
+		}
+		if (literals + 16 <= input_left && literals + 16 <= output_left) {
+			detail::lz4_wild_copy(output, input, literals);
+		}
+		else if (literals > 0) {
+			::std::memcpy(output, input, literals);
+		}
+		input += literals;
+		output += literals;
+
+		// The last sequence has only literals
+		if (input == input_end) {
+			return static_cast<::std::size_t>(output - output_begin);
+		}
+		if (input_end - input < 2) {
+			return ::std::nullopt;
+		}
+		const auto offset = static_cast<::std::size_t>(input[0] | (input[1] << 8));
+		input += 2;
+		if (offset == 0 || offset > static_cast<::std::size_t>(output - output_begin)) {
+			return ::std::nullopt;
+		}
+		::std::size_t match = token & 15;
+		if (match == 15 && !detail::lz4_read_length(input, input_end, match)) {
+			return ::std::nullopt;
+		}
+		match += detail::lz4_min_match;
+		if (match > static_cast<::std::size_t>(output_end - output)) {
+			return ::std::nullopt;
+		}
+
+		const auto *reference = output - offset;
+		if (offset >= 16 && match + 16 <= static_cast<::std::size_t>(output_end - output)) {
+			detail::lz4_wild_copy(output, reference, match);
+			output += match;
+		}
+		else {
+			// Short offsets overlap the output and repeat a pattern, so copy one byte at a time
+			for (const auto *const end = output + match; output != end; ++output, ++reference) {
+				*output = *reference;
+			}
+		}
+	}
+}
+
+
+template <typename Type>
+class compressed_reader;
+
+
+namespace detail {
+
+// Each block starts with its stored size and decompressed size as little endian 32-bit values,
+// and the top bit of the stored size marks blocks kept uncompressed
+inline constexpr ::std::uint32_t compressed_block_raw = 0x80000000u;
+
+// Largest decompressed block, readers reject larger sizes as corrupt instead of allocating them
+inline constexpr ::std::size_t compressed_block_limit = ::std::size_t{64} << 20;
+
+inline void write_block_header(unsigned char *header, ::std::uint32_t stored,
+                               ::std::uint32_t size) noexcept {
+	for (int byte = 0; byte < 4; ++byte) {
+		header[byte] = static_cast<unsigned char>(stored >> (byte * 8));
+		header[byte + 4] = static_cast<unsigned char>(size >> (byte * 8));
+	}
+}
+
+XTR_NODISCARD inline ::std::uint32_t read_block_word(const unsigned char *word) noexcept {
+	return static_cast<::std::uint32_t>(word[0]) | (static_cast<::std::uint32_t>(word[1]) << 8)
+	       | (static_cast<::std::uint32_t>(word[2]) << 16)
+	       | (static_cast<::std::uint32_t>(word[3]) << 24);
+}
+
+// Grow-only buffer whose elements are left uninitialized, unlike std::vector::resize
+template <typename Type>
+class block_buffer {
+	::std::unique_ptr<Type[]> m_data;
+	::std::size_t m_capacity = 0;
+
+public:
+	// Returns room for count elements, the previous contents are lost when it grows
+	XTR_NODISCARD Type *reserve(::std::size_t count) {
+		if (count > m_capacity) {
+			m_capacity = 0;
+			m_data.reset();
+			m_data.reset(new Type[count]);
+			m_capacity = count;
+		}
+		return m_data.get();
+	}
+};
+
+template <typename Type>
+class compressed_reader_iterator {
+public:
+	using iterator_category = ::std::input_iterator_tag;
+	using value_type = Type;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = const Type *;
+	using reference = const Type &;
+
+	compressed_reader<Type> *m_reader = nullptr;
+	const Type *m_current = nullptr;
+	const Type *m_end = nullptr;
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return *m_current;
+	}
+
+	XTR_NODISCARD pointer operator->() const noexcept {
+		return m_current;
+	}
+
+	compressed_reader_iterator &operator++() {
+		if (++m_current == m_end) {
+			m_reader->next_block(*this);
+		}
+		return *this;
+	}
+
+	XTR_NODISCARD friend bool operator==(const compressed_reader_iterator &left,
+	                                     const compressed_reader_iterator &right) noexcept {
+		return left.m_current == right.m_current;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const compressed_reader_iterator &left,
+	                                     const compressed_reader_iterator &right) noexcept {
+		return left.m_current != right.m_current;
+	}
+};
+
+} // namespace detail
+
+
+// Writes trivially copyable records to a stream as independently LZ4 compressed blocks of at
+// most 64 MiB
+template <typename Type>
+class compressed_writer {
+public:
+	static_assert(::std::is_trivially_copyable_v<Type>, "Type must be trivially copyable");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+
+private:
+	::std::ostream *m_stream;
+	::std::vector<Type> m_block;
+	::std::vector<unsigned char> m_compressed;
+	size_type m_block_records;
+
+public:
+	explicit compressed_writer(::std::ostream &stream,
+	                           size_type block_bytes = ::std::size_t{1} << 20) :
+	    m_stream{&stream},
+	    m_block_records{block_bytes / sizeof(Type) > 0 ? block_bytes / sizeof(Type) : 1} {
+		assert(m_block_records * sizeof(Type) <= detail::compressed_block_limit);
+		m_block.reserve(m_block_records);
+		m_compressed.resize(8 + lz4_compress_bound(m_block_records * sizeof(Type)));
+	}
+
+	compressed_writer(const compressed_writer &) = delete;
+	compressed_writer &operator=(const compressed_writer &) = delete;
+
+	~compressed_writer() {
+		flush();
+	}
+
+
+	void push(const Type &value) {
+		m_block.push_back(value);
+		if (m_block.size() == m_block_records) {
+			flush();
+		}
+	}
+
+	// Writes the buffered records as a block, blocks that do not shrink are stored as is
+	void flush() {
+		if (m_block.empty()) {
+			return;
+		}
+		const auto bytes = m_block.size() * sizeof(Type);
+		const auto compressed = lz4_compress(m_block.data(), bytes, m_compressed.data() + 8,
+		                                     m_compressed.size() - 8);
+		if (compressed && *compressed < bytes) {
+			detail::write_block_header(m_compressed.data(),
+			                           static_cast<::std::uint32_t>(*compressed),
+			                           static_cast<::std::uint32_t>(bytes));
+			m_stream->write(reinterpret_cast<const char *>(m_compressed.data()),
+			                static_cast<::std::streamsize>(8 + *compressed));
+		}
+		else {
+			detail::write_block_header(m_compressed.data(),
+			                           static_cast<::std::uint32_t>(bytes)
+			                               | detail::compressed_block_raw,
+			                           static_cast<::std::uint32_t>(bytes));
+			m_stream->write(reinterpret_cast<const char *>(m_compressed.data()), 8);
+			m_stream->write(reinterpret_cast<const char *>(m_block.data()),
+			                static_cast<::std::streamsize>(bytes));
+		}
+		m_block.clear();
+	}
+};
+
+
+// Single pass reader of a stream written by compressed_writer, each block is decompressed into
+// the same buffer and its records are referenced in place
+template <typename Type>
+class compressed_reader {
+public:
+	static_assert(::std::is_trivially_copyable_v<Type>, "Type must be trivially copyable");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using iterator = detail::compressed_reader_iterator<Type>;
+	using const_iterator = iterator;
+
+	friend iterator;
+
+private:
+	::std::istream *m_stream;
+	detail::block_buffer<Type> m_block;
+	detail::block_buffer<unsigned char> m_compressed;
+
+public:
+	explicit compressed_reader(::std::istream &stream) : m_stream{&stream} {}
+
+
+	XTR_NODISCARD iterator begin() {
+		iterator result;
+		result.m_reader = this;
+		next_block(result);
+		return result;
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return iterator{};
+	}
+
+private:
+	[[noreturn]] static void corrupt() {
+		throw ::std::runtime_error{"xtr::compressed_reader: corrupt block"};
+	}
+
+	// Points the iterator at the records of the next non-empty block, or at the end of the stream
+	void next_block(iterator &position) {
+		position.m_current = nullptr;
+		position.m_end = nullptr;
+		for (;;) {
+			unsigned char header[8];
+			m_stream->read(reinterpret_cast<char *>(header), sizeof(header));
+			if (m_stream->gcount() == 0) {
+				return;
+			}
+			if (m_stream->gcount() != sizeof(header)) {
+				corrupt();
+			}
+			const auto stored = detail::read_block_word(header);
+			const auto bytes = static_cast<size_type>(detail::read_block_word(header + 4));
+			const auto payload = static_cast<size_type>(stored & ~detail::compressed_block_raw);
+			if (bytes % sizeof(Type) != 0 || bytes > detail::compressed_block_limit) {
+				corrupt();
+			}
+			const auto count = bytes / sizeof(Type);
+			auto *const records = m_block.reserve(count);
+			auto *const target = reinterpret_cast<char *>(records);
+
+			if ((stored & detail::compressed_block_raw) != 0) {
+				if (payload != bytes) {
+					corrupt();
+				}
+				m_stream->read(target, static_cast<::std::streamsize>(bytes));
+				if (static_cast<size_type>(m_stream->gcount()) != bytes) {
+					corrupt();
+				}
+			}
+			else {
+				if (payload > lz4_compress_bound(bytes)) {
+					corrupt();
+				}
+				auto *const compressed = m_compressed.reserve(payload);
+				m_stream->read(reinterpret_cast<char *>(compressed),
+				               static_cast<::std::streamsize>(payload));
+				if (static_cast<size_type>(m_stream->gcount()) != payload) {
+					corrupt();
+				}
+				const auto result = lz4_decompress(compressed, payload, target, bytes);
+				if (!result || *result != bytes) {
+					corrupt();
+				}
+			}
+			if (count > 0) {
+				position.m_current = records;
+				position.m_end = records + count;
+				return;
+			}
+		}
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_COMPRESSION
+
+
+// Aggregate serialization in C++
+#if defined(XTR_SERIALIZE) && defined(__cplusplus)
+
+namespace xtr {
+
+// Non-owning view of trivially copyable elements, deserializing into it references the buffer
+// instead of copying, and it serializes the same as a std::vector of its elements
+template <typename Type>
+class serial_view {
+public:
+	static_assert(::std::is_trivially_copyable_v<Type>, "Type must be trivially copyable");
+
+	using value_type = Type;
+	using size_type = ::std::size_t;
+	using iterator = const Type *;
+	using const_iterator = const Type *;
+
+private:
+	const Type *m_data = nullptr;
+	size_type m_size = 0;
+
+public:
+	XTR_CONSTEXPR serial_view() noexcept = default;
+
+	XTR_CONSTEXPR serial_view(const Type *data, size_type size) noexcept :
+	    m_data{data}, m_size{size} {}
+
+	template <typename Range,
+	          typename = ::std::enable_if_t<::std::is_convertible_v<
+	              decltype(::std::data(::std::declval<const Range &>())), const Type *>>>
+	XTR_CONSTEXPR serial_view(const Range &range) noexcept :
+	    m_data{::std::data(range)}, m_size{::std::size(range)} {}
+
+
+	XTR_NODISCARD XTR_CONSTEXPR const Type *data() const noexcept {
+		return m_data;
+	}
+
+	XTR_NODISCARD XTR_CONSTEXPR size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD XTR_CONSTEXPR bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD XTR_CONSTEXPR const_iterator begin() const noexcept {
+		return m_data;
+	}
+
+	XTR_NODISCARD XTR_CONSTEXPR const_iterator end() const noexcept {
+		return m_data + m_size;
+	}
+
+	XTR_NODISCARD XTR_CONSTEXPR const Type &operator[](size_type index) const noexcept {
+		assert(index < m_size);
+		return m_data[index];
+	}
+};
+
+
+namespace detail {
+
+// Aggregates with more fields than this are not reflected
+inline constexpr ::std::size_t serial_max_fields = 16;
+
+// Converts to any field type, so an aggregate is brace initializable from as many of these as it
+// has fields, the conversion is never evaluated
+struct serial_any_field {
+	template <typename Type>
+	operator Type &() const noexcept;
+};
+
+template <::std::size_t>
+using serial_any_field_t = serial_any_field;
+
+template <typename Type, typename Indices, typename = void>
+struct is_serial_initializable : ::std::false_type {};
+
+template <typename Type, ::std::size_t... Indices>
+struct is_serial_initializable<Type, ::std::index_sequence<Indices...>,
+                               ::std::void_t<decltype(Type{serial_any_field_t<Indices>{}...})>> :
+    ::std::true_type {};
+
+template <typename Type, ::std::size_t Count = 0>
+XTR_NODISCARD constexpr ::std::size_t serial_field_count() noexcept {
+	if constexpr (Count <= serial_max_fields
+	              && is_serial_initializable<Type, ::std::make_index_sequence<Count + 1>>::value) {
+		return serial_field_count<Type, Count + 1>();
+	}
+	else {
+		return Count;
+	}
+}
+
+// Binds the fields of an aggregate with a structured binding and returns references to them
+template <typename Type>
+XTR_NODISCARD constexpr auto serial_tie(Type &value) noexcept {
+	constexpr auto Fields = serial_field_count<::std::remove_const_t<Type>>();
+	static_assert(Fields <= serial_max_fields,
+	              "Type has more fields than xtr::serialize can reflect");
+	if constexpr (Fields == 0) {
+		return ::std::tie();
+	}
+	else if constexpr (Fields == 1) {
+		auto &[f0] = value;
+		return ::std::tie(f0);
+	}
+	else if constexpr (Fields == 2) {
+		auto &[f0, f1] = value;
+		return ::std::tie(f0, f1);
+	}
+	else if constexpr (Fields == 3) {
+		auto &[f0, f1, f2] = value;
+		return ::std::tie(f0, f1, f2);
+	}
+	else if constexpr (Fields == 4) {
+		auto &[f0, f1, f2, f3] = value;
+		return ::std::tie(f0, f1, f2, f3);
+	}
+	else if constexpr (Fields == 5) {
+		auto &[f0, f1, f2, f3, f4] = value;
+		return ::std::tie(f0, f1, f2, f3, f4);
+	}
+	else if constexpr (Fields == 6) {
+		auto &[f0, f1, f2, f3, f4, f5] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5);
+	}
+	else if constexpr (Fields == 7) {
+		auto &[f0, f1, f2, f3, f4, f5, f6] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6);
+	}
+	else if constexpr (Fields == 8) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+	}
+	else if constexpr (Fields == 9) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+	}
+	else if constexpr (Fields == 10) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+	}
+	else if constexpr (Fields == 11) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+	}
+	else if constexpr (Fields == 12) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+	}
+	else if constexpr (Fields == 13) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+	}
+	else if constexpr (Fields == 14) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+	}
+	else if constexpr (Fields == 15) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+	}
+	else if constexpr (Fields == 16) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = value;
+		return ::std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+	}
+}
+
+
+template <typename Type>
+struct is_serial_view : ::std::false_type {};
+
+template <typename Type>
+struct is_serial_view<serial_view<Type>> : ::std::true_type {};
+
+template <typename Type>
+struct is_serial_vector : ::std::false_type {};
+
+template <typename Type, typename Allocator>
+struct is_serial_vector<::std::vector<Type, Allocator>> : ::std::true_type {};
+
+template <typename Type>
+struct is_serial_string : ::std::false_type {};
+
+template <typename Char, typename Traits, typename Allocator>
+struct is_serial_string<::std::basic_string<Char, Traits, Allocator>> : ::std::true_type {};
+
+template <typename Type>
+struct is_serial_string_view : ::std::false_type {};
+
+template <typename Char, typename Traits>
+struct is_serial_string_view<::std::basic_string_view<Char, Traits>> : ::std::true_type {};
+
+// Arrays of trivially copyable elements have a fixed size and are copied in bulk
+template <typename Type>
+struct is_serial_bulk_array : ::std::false_type {};
+
+template <typename Type, ::std::size_t Size>
+struct is_serial_bulk_array<::std::array<Type, Size>> :
+    ::std::bool_constant<::std::is_trivially_copyable_v<Type>> {};
+
+template <typename Type, typename = void>
+struct is_serial_tuple : ::std::false_type {};
+
+template <typename Type>
+struct is_serial_tuple<Type, ::std::void_t<decltype(::std::tuple_size<Type>::value)>> :
+    ::std::true_type {};
+
+// Ranges are written as a 64-bit element count followed by the elements
+template <typename Type>
+inline constexpr bool is_serial_range_v = is_serial_view<Type>::value
+                                          || is_serial_vector<Type>::value
+                                          || is_serial_string<Type>::value
+                                          || is_serial_string_view<Type>::value;
+
+template <typename>
+inline constexpr bool serial_dependent_false_v = false;
+
+template <typename Type>
+XTR_NODISCARD constexpr ::std::size_t serial_min_size() noexcept;
+
+template <typename Tuple, ::std::size_t... Indices>
+XTR_NODISCARD constexpr ::std::size_t
+serial_min_tuple_size(::std::index_sequence<Indices...>) noexcept {
+	return (::std::size_t{0} + ...
+	        + serial_min_size<::std::remove_cv_t<
+	            ::std::remove_reference_t<::std::tuple_element_t<Indices, Tuple>>>>());
+}
+
+// Fewest bytes a value of Type serializes to, ranges count only their element count
+template <typename Type>
+XTR_NODISCARD constexpr ::std::size_t serial_min_size() noexcept {
+	if constexpr (is_serial_range_v<Type>) {
+		return sizeof(::std::uint64_t);
+	}
+	else if constexpr (::std::is_arithmetic_v<Type> || ::std::is_enum_v<Type>
+	                   || is_serial_bulk_array<Type>::value) {
+		return sizeof(Type);
+	}
+	else if constexpr (is_serial_tuple<Type>::value) {
+		return serial_min_tuple_size<Type>(::std::make_index_sequence<::std::tuple_size_v<Type>>{});
+	}
+	else if constexpr (::std::is_aggregate_v<Type>) {
+		using fields = decltype(serial_tie(::std::declval<Type &>()));
+		return serial_min_tuple_size<fields>(
+		    ::std::make_index_sequence<::std::tuple_size_v<fields>>{});
+	}
+	else {
+		return sizeof(Type);
+	}
+}
+
+
+class serial_writer {
+	::std::vector<unsigned char> *m_output;
+	::std::size_t m_base;
+
+public:
+	explicit serial_writer(::std::vector<unsigned char> &output) noexcept :
+	    m_output{&output}, m_base{output.size()} {}
+
+
+	void write(const void *source, ::std::size_t size) {
+		const auto *const bytes = static_cast<const unsigned char *>(source);
+		m_output->insert(m_output->end(), bytes, bytes + size);
+	}
+
+	// Pads so the next write is aligned relative to the start of the message
+	void align(::std::size_t alignment) {
+		const auto offset = m_output->size() - m_base;
+		m_output->resize(m_output->size() + (alignment - offset % alignment) % alignment);
+	}
+};
+
+class serial_reader {
+	const unsigned char *m_base;
+	const unsigned char *m_current;
+	const unsigned char *m_end;
+
+public:
+	serial_reader(const void *source, ::std::size_t size) noexcept :
+	    m_base{static_cast<const unsigned char *>(source)}, m_current{m_base},
+	    m_end{m_base + size} {}
+
+
+	XTR_NODISCARD bool done() const noexcept {
+		return m_current == m_end;
+	}
+
+	XTR_NODISCARD ::std::size_t remaining() const noexcept {
+		return static_cast<::std::size_t>(m_end - m_current);
+	}
+
+	// Returns the next size bytes and skips past them, or nullptr when too few are left
+	XTR_NODISCARD const unsigned char *take(::std::size_t size) noexcept {
+		if (size > remaining()) {
+			return nullptr;
+		}
+		const auto *const result = m_current;
+		m_current += size;
+		return result;
+	}
+
+	XTR_NODISCARD bool read(void *destination, ::std::size_t size) noexcept {
+		const auto *const source = take(size);
+		if (source == nullptr) {
+			return false;
+		}
+		if (size > 0) {
+			::std::memcpy(destination, source, size);
+		}
+		return true;
+	}
+
+	XTR_NODISCARD bool align(::std::size_t alignment) noexcept {
+		const auto offset = static_cast<::std::size_t>(m_current - m_base);
+		return take((alignment - offset % alignment) % alignment) != nullptr;
+	}
+};
+
+
+template <typename Type>
+void serialize_value(serial_writer &writer, const Type &value) {
+	if constexpr (::std::is_arithmetic_v<Type> || ::std::is_enum_v<Type>) {
+		writer.write(&value, sizeof(value));
+	}
+	else if constexpr (is_serial_range_v<Type>) {
+		using element_type = ::std::remove_const_t<typename Type::value_type>;
+		static_assert(!::std::is_same_v<Type, ::std::vector<bool>>,
+		              "std::vector<bool> is not serializable");
+
+		const auto count = static_cast<::std::uint64_t>(value.size());
+		writer.write(&count, sizeof(count));
+		if constexpr (::std::is_trivially_copyable_v<element_type>) {
+			writer.align(alignof(element_type));
+			writer.write(value.data(), value.size() * sizeof(element_type));
+		}
+		else {
+			for (const auto &element : value) {
+				serialize_value(writer, element);
+			}
+		}
+	}
+	else if constexpr (is_serial_bulk_array<Type>::value) {
+		writer.write(value.data(), sizeof(value));
+	}
+	else if constexpr (is_serial_tuple<Type>::value) {
+		::std::apply([&](const auto &...elements) { (serialize_value(writer, elements), ...); },
+		             value);
+	}
+	else if constexpr (::std::is_aggregate_v<Type>) {
+		::std::apply([&](const auto &...fields) { (serialize_value(writer, fields), ...); },
+		             serial_tie(value));
+	}
+	else if constexpr (::std::is_trivially_copyable_v<Type>) {
+		writer.write(&value, sizeof(value));
+	}
+	else {
+		static_assert(serial_dependent_false_v<Type>, "Type is not serializable");
+	}
+}
+
+template <typename Type>
+XTR_NODISCARD bool deserialize_value(serial_reader &reader, Type &value) {
+	if constexpr (::std::is_arithmetic_v<Type> || ::std::is_enum_v<Type>) {
+		return reader.read(&value, sizeof(value));
+	}
+	else if constexpr (is_serial_range_v<Type>) {
+		using element_type = ::std::remove_const_t<typename Type::value_type>;
+		static_assert(!::std::is_same_v<Type, ::std::vector<bool>>,
+		              "std::vector<bool> is not serializable");
+
+		::std::uint64_t count;
+		if (!reader.read(&count, sizeof(count))) {
+			return false;
+		}
+		if constexpr (::std::is_trivially_copyable_v<element_type>) {
+			if (!reader.align(alignof(element_type))
+			    || count > reader.remaining() / sizeof(element_type)) {
+				return false;
+			}
+			const auto size = static_cast<::std::size_t>(count);
+			const auto *const source = reader.take(size * sizeof(element_type));
+			if constexpr (is_serial_view<Type>::value || is_serial_string_view<Type>::value) {
+				// Views point into the buffer, which must be aligned for their elements
+				if (reinterpret_cast<::std::uintptr_t>(source) % alignof(element_type) != 0) {
+					return false;
+				}
+				value = Type{reinterpret_cast<const element_type *>(source), size};
+			}
+			else {
+				value.resize(size);
+				if (size > 0) {
+					::std::memcpy(value.data(), source, size * sizeof(element_type));
+				}
+			}
+			return true;
+		}
+		else {
+			// Elements that take at least a byte bound the count before allocating, empty ones
+			// consume no input and only have to fit
+			constexpr auto element_size = serial_min_size<element_type>();
+			if constexpr (element_size > 0) {
+				if (count > reader.remaining() / element_size) {
+					return false;
+				}
+			}
+			else {
+				if (count > value.max_size()) {
+					return false;
+				}
+			}
+			value.clear();
+			value.resize(static_cast<::std::size_t>(count));
+			for (auto &element : value) {
+				if (!deserialize_value(reader, element)) {
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+	else if constexpr (is_serial_bulk_array<Type>::value) {
+		return reader.read(value.data(), sizeof(value));
+	}
+	else if constexpr (is_serial_tuple<Type>::value) {
+		return ::std::apply(
+		    [&](auto &...elements) { return (deserialize_value(reader, elements) && ...); }, value);
+	}
+	else if constexpr (::std::is_aggregate_v<Type>) {
+		return ::std::apply(
+		    [&](auto &...fields) { return (deserialize_value(reader, fields) && ...); },
+		    serial_tie(value));
+	}
+	else if constexpr (::std::is_trivially_copyable_v<Type>) {
+		return reader.read(&value, sizeof(value));
+	}
+	else {
+		static_assert(serial_dependent_false_v<Type>, "Type is not serializable");
+	}
+}
+
+} // namespace detail
+
+
+// Appends the binary representation of value to output, aggregates are written field by field and
+// ranges of trivially copyable elements are copied in bulk, all in native byte order
+template <typename Type>
+void serialize(const Type &value, ::std::vector<unsigned char> &output) {
+	detail::serial_writer writer{output};
+	detail::serialize_value(writer, value);
+}
+
+template <typename Type>
+XTR_NODISCARD ::std::vector<unsigned char> serialize(const Type &value) {
+	::std::vector<unsigned char> output;
+	serialize(value, output);
+	return output;
+}
+
+
+// Reads a value written by serialize, or nothing when the bytes are malformed or not all used,
+// std::string_view and xtr::serial_view fields reference the bytes which must outlive them
+template <typename Type>
+XTR_NODISCARD ::std::optional<Type> deserialize(const void *data, ::std::size_t size) {
+	detail::serial_reader reader{data, size};
+	::std::optional<Type> result{::std::in_place};
+	if (!detail::deserialize_value(reader, *result) || !reader.done()) {
+		return ::std::nullopt;
+	}
+	return result;
+}
+
+} // namespace xtr
+
+#endif // XTR_SERIALIZE
+
+
+// CRC32C checksums in C++
+#if defined(XTR_CHECKSUM) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+// Castagnoli polynomial in reflected bit order, where x^k is bit 31 - k
+inline constexpr ::std::uint32_t crc32c_polynomial = 0x82f63b78u;
+
+// Long buffers are hashed as three streams side by side to hide the latency of the instruction
+inline constexpr ::std::size_t crc32c_long_stream = 8192;
+inline constexpr ::std::size_t crc32c_short_stream = 256;
+
+// Product of two polynomials modulo the CRC polynomial
+XTR_NODISCARD inline ::std::uint32_t crc32c_multiply(::std::uint32_t left,
+                                                     ::std::uint32_t right) noexcept {
+	::std::uint32_t product = 0;
+	for (::std::uint32_t bit = 0x80000000u; bit != 0; bit >>= 1) {
+		if ((left & bit) != 0) {
+			product ^= right;
+		}
+		right = (right & 1) != 0 ? (right >> 1) ^ crc32c_polynomial : right >> 1;
+	}
+	return product;
+}
+
+// Returns x^(8 * bytes), multiplying a CRC by it appends that many zero bytes
+XTR_NODISCARD inline ::std::uint32_t crc32c_zeros(::std::size_t bytes) noexcept {
+	::std::uint32_t result = 0x80000000u;
+	for (::std::uint32_t power = 0x00800000u; bytes != 0; bytes >>= 1) {
+		if ((bytes & 1) != 0) {
+			result = crc32c_multiply(power, result);
+		}
+		power = crc32c_multiply(power, power);
+	}
+	return result;
+}
+
+struct crc32c_tables {
+	::std::uint32_t m_slice[8][256];
+	// Append the stream lengths in zero bytes to a CRC one byte of it at a time
+	::std::uint32_t m_long[4][256];
+	::std::uint32_t m_short[4][256];
+};
+
+inline void build_crc32c_tables(crc32c_tables &tables) noexcept {
+	for (::std::uint32_t byte = 0; byte < 256; ++byte) {
+		auto crc = byte;
+		for (int bit = 0; bit < 8; ++bit) {
+			crc = (crc & 1) != 0 ? (crc >> 1) ^ crc32c_polynomial : crc >> 1;
+		}
+		tables.m_slice[0][byte] = crc;
+	}
+	for (::std::uint32_t byte = 0; byte < 256; ++byte) {
+		for (int slice = 1; slice < 8; ++slice) {
+			const auto previous = tables.m_slice[slice - 1][byte];
+			tables.m_slice[slice][byte] = (previous >> 8) ^ tables.m_slice[0][previous & 0xff];
+		}
+	}
+	const auto long_zeros = crc32c_zeros(crc32c_long_stream);
+	const auto short_zeros = crc32c_zeros(crc32c_short_stream);
+	for (int position = 0; position < 4; ++position) {
+		for (::std::uint32_t byte = 0; byte < 256; ++byte) {
+			tables.m_long[position][byte] = crc32c_multiply(long_zeros, byte << (position * 8));
+			tables.m_short[position][byte] = crc32c_multiply(short_zeros, byte << (position * 8));
+		}
+	}
+}
+
+// Built on first use, as constants the tables would slow down every translation unit
+XTR_NODISCARD inline const crc32c_tables &crc32c_table() noexcept {
+	static crc32c_tables tables;
+	static const bool built = (build_crc32c_tables(tables), true);
+	static_cast<void>(built);
+	return tables;
+}
+
+XTR_NODISCARD inline ::std::uint32_t crc32c_shift(const ::std::uint32_t (&table)[4][256],
+                                                  ::std::uint32_t crc) noexcept {
+	return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^ table[2][(crc >> 16) & 0xff]
+	       ^ table[3][crc >> 24];
+}
+
+XTR_NODISCARD inline ::std::uint32_t crc32c_load(const unsigned char *data) noexcept {
+	return static_cast<::std::uint32_t>(data[0]) | (static_cast<::std::uint32_t>(data[1]) << 8)
+	       | (static_cast<::std::uint32_t>(data[2]) << 16)
+	       | (static_cast<::std::uint32_t>(data[3]) << 24);
+}
+
+// Slicing by 8, eight table lookups for every 8 bytes
+XTR_NODISCARD inline ::std::uint32_t crc32c_software(::std::uint32_t crc, const unsigned char *data,
+                                                     ::std::size_t size) noexcept {
+	const auto &table = crc32c_table().m_slice;
+	for (; size >= 8; size -= 8, data += 8) {
+		const auto low = crc32c_load(data) ^ crc;
+		const auto high = crc32c_load(data + 4);
+		crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^ table[5][(low >> 16) & 0xff]
+		      ^ table[4][low >> 24] ^ table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff]
+		      ^ table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+	}
+	for (; size > 0; --size) {
+		crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xff];
+	}
+	return crc;
+}
+
+#if defined(XTR_SIMD_SSE42)
+
+XTR_NODISCARD inline ::std::uint32_t crc32c_word(::std::uint32_t crc,
+                                                 const unsigned char *data) noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+	::std::uint64_t word;
+	::std::memcpy(&word, data, sizeof(word));
+	return static_cast<::std::uint32_t>(_mm_crc32_u64(crc, word));
+#else
+	::std::uint32_t words[2];
+	::std::memcpy(words, data, sizeof(words));
+	return _mm_crc32_u32(_mm_crc32_u32(crc, words[0]), words[1]);
+#endif
+}
+
+XTR_NODISCARD inline ::std::uint32_t crc32c_hardware(::std::uint32_t crc, const unsigned char *data,
+                                                     ::std::size_t size) noexcept {
+	for (; size > 0 && reinterpret_cast<::std::uintptr_t>(data) % 8 != 0; --size) {
+		crc = _mm_crc32_u8(crc, *data++);
+	}
+	if (size >= crc32c_short_stream * 3) {
+		// Each stream after the first starts from zero, and the CRCs are joined by appending the
+		// length of the following streams to them, as CRCs without the final inversion are linear
+		const auto &tables = crc32c_table();
+		const auto interleave = [&](::std::size_t stream, const ::std::uint32_t(&shift)[4][256]) {
+			for (; size >= stream * 3; size -= stream * 3, data += stream * 3) {
+				::std::uint32_t second = 0;
+				::std::uint32_t third = 0;
+				for (::std::size_t i = 0; i < stream; i += 8) {
+					crc = crc32c_word(crc, data + i);
+					second = crc32c_word(second, data + stream + i);
+					third = crc32c_word(third, data + stream * 2 + i);
+				}
+				crc = crc32c_shift(shift, crc32c_shift(shift, crc) ^ second) ^ third;
+			}
+		};
+		interleave(crc32c_long_stream, tables.m_long);
+		interleave(crc32c_short_stream, tables.m_short);
+	}
+	for (; size >= 8; size -= 8, data += 8) {
+		crc = crc32c_word(crc, data);
+	}
+	for (; size > 0; --size) {
+		crc = _mm_crc32_u8(crc, *data++);
+	}
+	return crc;
+}
+
+#endif
+
+} // namespace detail
+
+
+// Continues the CRC32C of earlier bytes over size more bytes, extending zero gives crc32c
+XTR_NODISCARD inline ::std::uint32_t crc32c_extend(::std::uint32_t crc, const void *data,
+                                                   ::std::size_t size) noexcept {
+	const auto *const bytes = static_cast<const unsigned char *>(data);
+#if defined(XTR_SIMD_SSE42)
+	return ~detail::crc32c_hardware(~crc, bytes, size);
+#else
+	return ~detail::crc32c_software(~crc, bytes, size);
+#endif
+}
+
+XTR_NODISCARD inline ::std::uint32_t crc32c(const void *data, ::std::size_t size) noexcept {
+	return crc32c_extend(0, data, size);
+}
+
+// Checksums the text of a null terminated string or string view
+XTR_NODISCARD inline ::std::uint32_t crc32c(::std::string_view text) noexcept {
+	return crc32c(text.data(), text.size());
+}
+
+// Checksums a char array such as a string literal, leaving out its terminating null if it has one
+template <::std::size_t Size>
+XTR_NODISCARD ::std::uint32_t crc32c(const char (&text)[Size]) noexcept {
+	return crc32c(text, text[Size - 1] == '\0' ? Size - 1 : Size);
+}
+
+// Checksums the bytes of a contiguous range of trivially copyable elements, char arrays are
+// handled above
+template <typename Range,
+          typename = ::std::enable_if_t<
+              ::std::is_trivially_copyable_v<
+                  ::std::remove_pointer_t<decltype(::std::data(::std::declval<const Range &>()))>>
+              && !::std::is_same_v<::std::remove_extent_t<Range>, char>>>
+XTR_NODISCARD ::std::uint32_t crc32c(const Range &range) noexcept {
+	return crc32c(::std::data(range), ::std::size(range) * sizeof(*::std::data(range)));
+}
+
+// CRC32C of two buffers joined together, from the CRC32C of each and the size of the second, so
+// that chunks can be checksummed independently
+XTR_NODISCARD inline ::std::uint32_t crc32c_combine(::std::uint32_t first, ::std::uint32_t second,
+                                                    ::std::size_t second_size) noexcept {
+	return detail::crc32c_multiply(detail::crc32c_zeros(second_size), first) ^ second;
+}
+
+} // namespace xtr
+
+#endif // XTR_CHECKSUM
+
+
+// Base64 and hex encoding in C++
+#if defined(XTR_TEXT_ENCODING) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+inline constexpr char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+inline constexpr char hex_digits[] = "0123456789abcdef";
+
+// Values of characters, or -1 for characters outside the alphabet
+struct text_decode_table {
+	signed char m_values[256];
+};
+
+XTR_NODISCARD constexpr text_decode_table make_text_decode_table(const char *alphabet,
+                                                                 int size) noexcept {
+	text_decode_table table{};
+	for (auto &value : table.m_values) {
+		value = -1;
+	}
+	for (int i = 0; i < size; ++i) {
+		table.m_values[static_cast<unsigned char>(alphabet[i])] = static_cast<signed char>(i);
+	}
+	return table;
+}
+
+inline constexpr text_decode_table base64_table = make_text_decode_table(base64_alphabet, 64);
+inline constexpr text_decode_table hex_table = [] {
+	auto table = make_text_decode_table(hex_digits, 16);
+	for (int i = 10; i < 16; ++i) {
+		table.m_values['A' + i - 10] = static_cast<signed char>(i);
+	}
+	return table;
+}();
+
+#if defined(XTR_SIMD_SSSE3)
+
+// Spreads 12 bytes into 16 sextets, one per byte, and maps them to characters with a shuffle
+// that selects the offset for each range of the alphabet
+XTR_NODISCARD inline __m128i base64_encode_lanes(__m128i input) noexcept {
+	input =
+	    _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+	const auto high = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)),
+	                                  _mm_set1_epi32(0x04000040));
+	const auto low = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003f03f0)),
+	                                 _mm_set1_epi32(0x01000010));
+	const auto sextets = _mm_or_si128(high, low);
+	// 0 to 25 select entry 13, 26 to 51 entry 0, and 52 to 63 entries 1 to 12
+	auto range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+	range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), sextets),
+	                                          _mm_set1_epi8(13)));
+	const auto offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+	                                   '/' - 63, 'A', 0, 0);
+	return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), sextets);
+}
+
+// Looks up the high nibbles allowed with each low nibble to validate characters, then maps them
+// to sextets with an offset for each high nibble, and returns false for invalid characters
+XTR_NODISCARD inline bool base64_decode_lanes(__m128i input, __m128i &sextets) noexcept {
+	const auto high = _mm_and_si128(_mm_srli_epi32(input, 4), _mm_set1_epi8(0x0f));
+	const auto low = _mm_and_si128(input, _mm_set1_epi8(0x0f));
+	const auto allowed =
+	    _mm_setr_epi8(-0x58, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x10,
+	                  0x54, 0x50, 0x50, 0x50, 0x54);
+	const auto bits = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, -0x80, 0, 0, 0, 0,
+	                                0, 0, 0, 0);
+	const auto invalid = _mm_cmpeq_epi8(
+	    _mm_and_si128(_mm_shuffle_epi8(allowed, low), _mm_shuffle_epi8(bits, high)),
+	    _mm_setzero_si128());
+	if (_mm_movemask_epi8(invalid) != 0) {
+		return false;
+	}
+	const auto offsets = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const auto slash = _mm_cmpeq_epi8(input, _mm_set1_epi8('/'));
+	const auto offset = _mm_or_si128(_mm_andnot_si128(slash, _mm_shuffle_epi8(offsets, high)),
+	                                 _mm_and_si128(slash, _mm_set1_epi8(16)));
+	sextets = _mm_add_epi8(input, offset);
+	return true;
+}
+
+// Joins 16 sextets into 12 bytes at the start of the result
+XTR_NODISCARD inline __m128i base64_pack_lanes(__m128i sextets) noexcept {
+	const auto pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+	const auto words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+	return _mm_shuffle_epi8(words,
+	                        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+// Maps hex digits to their values and marks other characters in invalid
+XTR_NODISCARD inline __m128i hex_decode_lanes(__m128i input, __m128i &invalid) noexcept {
+	const auto digit = _mm_sub_epi8(input, _mm_set1_epi8('0'));
+	const auto letter = _mm_sub_epi8(_mm_or_si128(input, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	const auto is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+	const auto is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+	invalid = _mm_or_si128(invalid, _mm_cmpeq_epi8(_mm_or_si128(is_digit, is_letter),
+	                                               _mm_setzero_si128()));
+	return _mm_or_si128(_mm_and_si128(is_digit, digit),
+	                    _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+#endif
+
+#if defined(XTR_SIMD_AVX2)
+
+// The same kernels on two independent 128-bit lanes
+XTR_NODISCARD inline __m256i base64_encode_lanes(__m256i input) noexcept {
+	input = _mm256_shuffle_epi8(input, _mm256_broadcastsi128_si256(_mm_setr_epi8(
+	                                       1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)));
+	const auto high = _mm256_mulhi_epu16(_mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00)),
+	                                     _mm256_set1_epi32(0x04000040));
+	const auto low = _mm256_mullo_epi16(_mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0)),
+	                                    _mm256_set1_epi32(0x01000010));
+	const auto sextets = _mm256_or_si256(high, low);
+	auto range = _mm256_subs_epu8(sextets, _mm256_set1_epi8(51));
+	range = _mm256_or_si256(range,
+	                        _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets),
+	                                         _mm256_set1_epi8(13)));
+	const auto offsets = _mm256_broadcastsi128_si256(
+	    _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	                  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+	return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), sextets);
+}
+
+XTR_NODISCARD inline bool base64_decode_lanes(__m256i input, __m256i &sextets) noexcept {
+	const auto high = _mm256_and_si256(_mm256_srli_epi32(input, 4), _mm256_set1_epi8(0x0f));
+	const auto low = _mm256_and_si256(input, _mm256_set1_epi8(0x0f));
+	const auto allowed = _mm256_broadcastsi128_si256(
+	    _mm_setr_epi8(-0x58, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x08, -0x10,
+	                  0x54, 0x50, 0x50, 0x50, 0x54));
+	const auto bits = _mm256_broadcastsi128_si256(
+	    _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, -0x80, 0, 0, 0, 0, 0, 0, 0, 0));
+	const auto invalid = _mm256_cmpeq_epi8(
+	    _mm256_and_si256(_mm256_shuffle_epi8(allowed, low), _mm256_shuffle_epi8(bits, high)),
+	    _mm256_setzero_si256());
+	if (_mm256_movemask_epi8(invalid) != 0) {
+		return false;
+	}
+	const auto offsets = _mm256_broadcastsi128_si256(
+	    _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+	const auto slash = _mm256_cmpeq_epi8(input, _mm256_set1_epi8('/'));
+	const auto offset =
+	    _mm256_or_si256(_mm256_andnot_si256(slash, _mm256_shuffle_epi8(offsets, high)),
+	                    _mm256_and_si256(slash, _mm256_set1_epi8(16)));
+	sextets = _mm256_add_epi8(input, offset);
+	return true;
+}
+
+// Joins 32 sextets into 24 bytes at the start of the result
+XTR_NODISCARD inline __m256i base64_pack_lanes(__m256i sextets) noexcept {
+	const auto pairs = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+	const auto words = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+	const auto packed = _mm256_shuffle_epi8(
+	    words, _mm256_broadcastsi128_si256(
+	               _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+	return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+}
+
+XTR_NODISCARD inline __m256i hex_decode_lanes(__m256i input, __m256i &invalid) noexcept {
+	const auto digit = _mm256_sub_epi8(input, _mm256_set1_epi8('0'));
+	const auto letter =
+	    _mm256_sub_epi8(_mm256_or_si256(input, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+	const auto is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+	const auto is_letter =
+	    _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+	invalid = _mm256_or_si256(invalid, _mm256_cmpeq_epi8(_mm256_or_si256(is_digit, is_letter),
+	                                                     _mm256_setzero_si256()));
+	return _mm256_or_si256(
+	    _mm256_and_si256(is_digit, digit),
+	    _mm256_and_si256(is_letter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+#endif
+
+} // namespace detail
+
+
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::size_t base64_encoded_size(::std::size_t size) noexcept {
+	return (size + 2) / 3 * 4;
+}
+
+// Largest decoded size of size characters, the actual size is smaller when there is padding
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::size_t base64_decoded_size(::std::size_t size) noexcept {
+	return size / 4 * 3;
+}
+
+// Encodes with the standard alphabet and padding and returns the number of characters written,
+// which is base64_encoded_size(size)
+inline ::std::size_t base64_encode(const void *source, ::std::size_t size, char *output) noexcept {
+	const auto *input = static_cast<const unsigned char *>(source);
+	const auto *const output_begin = output;
+#if defined(XTR_SIMD_AVX2)
+	// Each 128-bit lane reads 16 bytes and uses 12
+	for (; size >= 28; size -= 24, input += 24, output += 32) {
+		const auto lanes = _mm256_inserti128_si256(
+		    _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input))),
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + 12)), 1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output),
+		                    detail::base64_encode_lanes(lanes));
+	}
+#endif
+#if defined(XTR_SIMD_SSSE3)
+	for (; size >= 16; size -= 12, input += 12, output += 16) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output),
+		                 detail::base64_encode_lanes(
+		                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(input))));
+	}
+#endif
+	for (; size >= 3; size -= 3, input += 3, output += 4) {
+		const auto bits = static_cast<unsigned>(input[0] << 16 | input[1] << 8 | input[2]);
+		output[0] = detail::base64_alphabet[bits >> 18];
+		output[1] = detail::base64_alphabet[bits >> 12 & 63];
+		output[2] = detail::base64_alphabet[bits >> 6 & 63];
+		output[3] = detail::base64_alphabet[bits & 63];
+	}
+	if (size > 0) {
+		const auto bits = static_cast<unsigned>(input[0] << 16 | (size > 1 ? input[1] << 8 : 0));
+		output[0] = detail::base64_alphabet[bits >> 18];
+		output[1] = detail::base64_alphabet[bits >> 12 & 63];
+		output[2] = size > 1 ? detail::base64_alphabet[bits >> 6 & 63] : '=';
+		output[3] = '=';
+		output += 4;
+	}
+	return static_cast<::std::size_t>(output - output_begin);
+}
+
+// Decodes padded base64 and returns the number of bytes written, or nothing when the size is not
+// a multiple of 4 or a character is outside the alphabet, output needs base64_decoded_size bytes
+XTR_NODISCARD inline ::std::optional<::std::size_t> base64_decode(const char *source,
+                                                                  ::std::size_t size,
+                                                                  void *destination) noexcept {
+	if (size % 4 != 0) {
+		return ::std::nullopt;
+	}
+	const auto *input = source;
+	auto *output = static_cast<unsigned char *>(destination);
+	const auto *const output_begin = output;
+	const ::std::size_t padding =
+	    size == 0 || source[size - 1] != '=' ? 0 : source[size - 2] != '=' ? 1 : 2;
+	// Characters before the last group when it is padded
+	auto size_left = size - (padding > 0 ? 4 : 0);
+#if defined(XTR_SIMD_AVX2)
+	// Stores write 8 bytes past the output, which the following characters overwrite
+	for (; size_left >= 48; size_left -= 32, input += 32, output += 24) {
+		__m256i sextets;
+		if (!detail::base64_decode_lanes(
+		        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input)), sextets)) {
+			return ::std::nullopt;
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output),
+		                    detail::base64_pack_lanes(sextets));
+	}
+#endif
+#if defined(XTR_SIMD_SSSE3)
+	for (; size_left >= 24; size_left -= 16, input += 16, output += 12) {
+		__m128i sextets;
+		if (!detail::base64_decode_lanes(
+		        _mm_loadu_si128(reinterpret_cast<const __m128i *>(input)), sextets)) {
+			return ::std::nullopt;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), detail::base64_pack_lanes(sextets));
+	}
+#endif
+	const auto value = [](char character) -> int {
+		return detail::base64_table.m_values[static_cast<unsigned char>(character)];
+	};
+	for (; size_left >= 4; size_left -= 4, input += 4, output += 3) {
+		const int sextets[4] = {value(input[0]), value(input[1]), value(input[2]), value(input[3])};
+		if ((sextets[0] | sextets[1] | sextets[2] | sextets[3]) < 0) {
+			return ::std::nullopt;
+		}
+		const auto bits = static_cast<unsigned>(sextets[0] << 18 | sextets[1] << 12
+		                                        | sextets[2] << 6 | sextets[3]);
+		output[0] = static_cast<unsigned char>(bits >> 16);
+		output[1] = static_cast<unsigned char>(bits >> 8);
+		output[2] = static_cast<unsigned char>(bits);
+	}
+	if (padding > 0) {
+		const int sextets[3] = {value(input[0]), value(input[1]),
+		                        padding == 1 ? value(input[2]) : 0};
+		if ((sextets[0] | sextets[1] | sextets[2]) < 0) {
+			return ::std::nullopt;
+		}
+		const auto bits =
+		    static_cast<unsigned>(sextets[0] << 18 | sextets[1] << 12 | sextets[2] << 6);
+		*output++ = static_cast<unsigned char>(bits >> 16);
+		if (padding == 1) {
+			*output++ = static_cast<unsigned char>(bits >> 8);
+		}
+	}
+	return static_cast<::std::size_t>(output - output_begin);
+}
+
+XTR_NODISCARD inline ::std::string base64_encode(::std::string_view source) {
+	::std::string result(base64_encoded_size(source.size()), '\0');
+	base64_encode(source.data(), source.size(), result.data());
+	return result;
+}
+
+XTR_NODISCARD inline ::std::optional<::std::string> base64_decode(::std::string_view source) {
+	::std::string result(base64_decoded_size(source.size()), '\0');
+	const auto size = base64_decode(source.data(), source.size(), result.data());
+	if (!size) {
+		return ::std::nullopt;
+	}
+	result.resize(*size);
+	return result;
+}
+
+
+// Encodes bytes as two lowercase hex digits each and returns the number of characters written
+inline ::std::size_t hex_encode(const void *source, ::std::size_t size, char *output) noexcept {
+	const auto *input = static_cast<const unsigned char *>(source);
+	const auto *const output_begin = output;
+#if defined(XTR_SIMD_AVX2)
+	const auto digits = _mm256_broadcastsi128_si256(
+	    _mm_loadu_si128(reinterpret_cast<const __m128i *>(detail::hex_digits)));
+	for (; size >= 32; size -= 32, input += 32, output += 64) {
+		const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input));
+		const auto high = _mm256_shuffle_epi8(
+		    digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f)));
+		const auto low =
+		    _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, _mm256_set1_epi8(0x0f)));
+		// Interleaving works within lanes, so the halves of each lane are put back in order
+		const auto first = _mm256_unpacklo_epi8(high, low);
+		const auto second = _mm256_unpackhi_epi8(high, low);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output),
+		                    _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output + 32),
+		                    _mm256_permute2x128_si256(first, second, 0x31));
+	}
+#endif
+#if defined(XTR_SIMD_SSSE3)
+	const auto lane_digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(detail::hex_digits));
+	for (; size >= 16; size -= 16, input += 16, output += 32) {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+		const auto high = _mm_shuffle_epi8(
+		    lane_digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f)));
+		const auto low = _mm_shuffle_epi8(lane_digits, _mm_and_si128(bytes, _mm_set1_epi8(0x0f)));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_unpacklo_epi8(high, low));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + 16), _mm_unpackhi_epi8(high, low));
+	}
+#endif
+	for (; size > 0; --size, ++input, output += 2) {
+		output[0] = detail::hex_digits[*input >> 4];
+		output[1] = detail::hex_digits[*input & 15];
+	}
+	return static_cast<::std::size_t>(output - output_begin);
+}
+
+// Decodes hex digits in either case and returns the number of bytes written, or nothing when the
+// size is odd or a character is not a hex digit
+XTR_NODISCARD inline ::std::optional<::std::size_t> hex_decode(const char *source,
+                                                               ::std::size_t size,
+                                                               void *destination) noexcept {
+	if (size % 2 != 0) {
+		return ::std::nullopt;
+	}
+	const auto *input = source;
+	auto *output = static_cast<unsigned char *>(destination);
+	const auto *const output_begin = output;
+#if defined(XTR_SIMD_AVX2)
+	for (; size >= 64; size -= 64, input += 64, output += 32) {
+		auto invalid = _mm256_setzero_si256();
+		const auto *const lanes = reinterpret_cast<const __m256i *>(input);
+		const auto first = detail::hex_decode_lanes(_mm256_loadu_si256(lanes), invalid);
+		const auto second = detail::hex_decode_lanes(_mm256_loadu_si256(lanes + 1), invalid);
+		if (_mm256_movemask_epi8(invalid) != 0) {
+			return ::std::nullopt;
+		}
+		// Joins each pair of digits, high digit first
+		const auto weights = _mm256_set1_epi16(0x0110);
+		const auto bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights),
+		                                       _mm256_maddubs_epi16(second, weights));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output),
+		                    _mm256_permute4x64_epi64(bytes, 0xd8));
+	}
+#endif
+#if defined(XTR_SIMD_SSSE3)
+	for (; size >= 32; size -= 32, input += 32, output += 16) {
+		auto invalid = _mm_setzero_si128();
+		const auto *const lanes = reinterpret_cast<const __m128i *>(input);
+		const auto first = detail::hex_decode_lanes(_mm_loadu_si128(lanes), invalid);
+		const auto second = detail::hex_decode_lanes(_mm_loadu_si128(lanes + 1), invalid);
+		if (_mm_movemask_epi8(invalid) != 0) {
+			return ::std::nullopt;
+		}
+		const auto weights = _mm_set1_epi16(0x0110);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output),
+		                 _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+		                                  _mm_maddubs_epi16(second, weights)));
+	}
+#endif
+	for (; size > 0; size -= 2, input += 2, ++output) {
+		const int high = detail::hex_table.m_values[static_cast<unsigned char>(input[0])];
+		const int low = detail::hex_table.m_values[static_cast<unsigned char>(input[1])];
+		if ((high | low) < 0) {
+			return ::std::nullopt;
+		}
+		*output = static_cast<unsigned char>(high << 4 | low);
+	}
+	return static_cast<::std::size_t>(output - output_begin);
+}
+
+XTR_NODISCARD inline ::std::string hex_encode(::std::string_view source) {
+	::std::string result(source.size() * 2, '\0');
+	hex_encode(source.data(), source.size(), result.data());
+	return result;
+}
+
+XTR_NODISCARD inline ::std::optional<::std::string> hex_decode(::std::string_view source) {
+	::std::string result(source.size() / 2, '\0');
+	if (!hex_decode(source.data(), source.size(), result.data())) {
+		return ::std::nullopt;
+	}
+	return result;
+}
+
+} // namespace xtr
+
+#endif // XTR_TEXT_ENCODING
+
+
+// CSV parsing in C++
+#if defined(XTR_CSV) && defined(__cplusplus)
+
+namespace xtr {
+
+struct csv_options {
+	char delimiter = ',';
+	char quote = '"';
+	// Input parsed at a time, rows stay valid until the next batch is parsed; zero picks 1 MiB
+	// per pool thread so each batch stays in cache between the passes over it
+	::std::size_t batch_bytes = 0;
+};
+
+
+// Fields of a row, quoted fields lose their outer quotes but keep doubled quotes inside
+class csv_row {
+public:
+	using value_type = ::std::string_view;
+	using size_type = ::std::size_t;
+	using iterator = const ::std::string_view *;
+	using const_iterator = iterator;
+
+private:
+	const ::std::string_view *m_fields = nullptr;
+	size_type m_size = 0;
+
+public:
+	csv_row() noexcept = default;
+
+	csv_row(const ::std::string_view *fields, size_type size) noexcept :
+	    m_fields{fields}, m_size{size} {}
+
+
+	XTR_NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	XTR_NODISCARD const_iterator begin() const noexcept {
+		return m_fields;
+	}
+
+	XTR_NODISCARD const_iterator end() const noexcept {
+		return m_fields + m_size;
+	}
+
+	XTR_NODISCARD ::std::string_view operator[](size_type index) const noexcept {
+		assert(index < m_size);
+		return m_fields[index];
+	}
+};
+
+
+// Replaces doubled quotes in a field with single ones
+XTR_NODISCARD inline ::std::string csv_unescape(::std::string_view field, char quote = '"') {
+	::std::string result;
+	result.reserve(field.size());
+	for (::std::size_t i = 0; i < field.size(); ++i) {
+		result += field[i];
+		if (field[i] == quote && i + 1 < field.size() && field[i + 1] == quote) {
+			++i;
+		}
+	}
+	return result;
+}
+
+
+class csv_reader;
+
+namespace detail {
+
+inline constexpr ::std::size_t csv_block_size = 64;
+inline constexpr ::std::size_t csv_min_chunk = ::std::size_t{1} << 20;
+
+// Sets bit i of the masks when byte i of a 64 byte block is a quote, or a delimiter or newline
+inline void csv_classify(const char *block, char delimiter, char quote, ::std::uint64_t &quotes,
+                         ::std::uint64_t &separators) noexcept {
+	quotes = 0;
+	separators = 0;
+#if defined(XTR_SIMD_AVX2)
+	const auto quote_lanes = _mm256_set1_epi8(quote);
+	const auto delimiter_lanes = _mm256_set1_epi8(delimiter);
+	const auto newline_lanes = _mm256_set1_epi8('\n');
+	for (int lane = 0; lane < 2; ++lane) {
+		const auto bytes =
+		    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + lane * 32));
+		const auto quote_bits = static_cast<::std::uint32_t>(
+		    _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote_lanes)));
+		const auto separator_bits = static_cast<::std::uint32_t>(
+		    _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, delimiter_lanes),
+		                                         _mm256_cmpeq_epi8(bytes, newline_lanes))));
+		quotes |= ::std::uint64_t{quote_bits} << (lane * 32);
+		separators |= ::std::uint64_t{separator_bits} << (lane * 32);
+	}
+#elif defined(XTR_SIMD_SSE2)
+	const auto quote_lanes = _mm_set1_epi8(quote);
+	const auto delimiter_lanes = _mm_set1_epi8(delimiter);
+	const auto newline_lanes = _mm_set1_epi8('\n');
+	for (int lane = 0; lane < 4; ++lane) {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + lane * 16));
+		const auto quote_bits =
+		    static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote_lanes)));
+		const auto separator_bits = static_cast<unsigned>(
+		    _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, delimiter_lanes),
+		                                   _mm_cmpeq_epi8(bytes, newline_lanes))));
+		quotes |= ::std::uint64_t{quote_bits} << (lane * 16);
+		separators |= ::std::uint64_t{separator_bits} << (lane * 16);
+	}
+#else
+	for (::std::size_t i = 0; i < csv_block_size; ++i) {
+		quotes |= ::std::uint64_t{block[i] == quote} << i;
+		separators |= ::std::uint64_t{block[i] == delimiter || block[i] == '\n'} << i;
+	}
+#endif
+}
+
+// Calls visit(block, quotes, separators) for each block of 64 bytes, the last one is copied and
+// masked to the end of the range
+template <typename Visit>
+void csv_scan(const char *first, const char *last, char delimiter, char quote, Visit &&visit) {
+	::std::uint64_t quotes;
+	::std::uint64_t separators;
+	for (; static_cast<::std::size_t>(last - first) >= csv_block_size; first += csv_block_size) {
+		csv_classify(first, delimiter, quote, quotes, separators);
+		visit(first, quotes, separators);
+	}
+	if (first != last) {
+		const auto size = static_cast<::std::size_t>(last - first);
+		char block[csv_block_size] = {};
+		::std::memcpy(block, first, size);
+		csv_classify(block, delimiter, quote, quotes, separators);
+		const auto mask = (::std::uint64_t{1} << size) - 1;
+		visit(first, quotes & mask, separators & mask);
+	}
+}
+
+struct csv_chunk {
+	// Offsets of delimiters and newlines outside quotes from the start of the batch
+	::std::vector<::std::uint32_t> m_separators;
+	::std::vector<::std::string_view> m_fields;
+	// Index in m_fields after the last field of each row
+	::std::vector<::std::size_t> m_row_ends;
+};
+
+class csv_reader_iterator {
+public:
+	using iterator_category = ::std::input_iterator_tag;
+	using value_type = csv_row;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = void;
+	using reference = csv_row;
+
+	csv_reader *m_reader = nullptr;
+	::std::size_t m_chunk = 0;
+	::std::size_t m_row = 0;
+
+
+	XTR_NODISCARD inline reference operator*() const noexcept;
+
+	inline csv_reader_iterator &operator++();
+
+	XTR_NODISCARD friend bool operator==(const csv_reader_iterator &left,
+	                                     const csv_reader_iterator &right) noexcept {
+		return left.m_reader == right.m_reader && left.m_chunk == right.m_chunk
+		       && left.m_row == right.m_row;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const csv_reader_iterator &left,
+	                                     const csv_reader_iterator &right) noexcept {
+		return !(left == right);
+	}
+};
+
+} // namespace detail
+
+
+// Single pass reader of CSV text in memory, such as a mapped file. Each batch is split into chunks
+// that are indexed in parallel: quotes are counted first to know whether each chunk starts inside
+// quotes, then delimiters and newlines outside quotes are found 64 bytes at a time with SIMD
+// masks, and finally each chunk splits the rows that start in it into fields. Blank lines are
+// skipped and a carriage return before a newline is removed
+class csv_reader {
+public:
+	using value_type = csv_row;
+	using size_type = ::std::size_t;
+	using iterator = detail::csv_reader_iterator;
+	using const_iterator = iterator;
+
+	friend iterator;
+
+private:
+	::std::string_view m_data;
+	csv_options m_options;
+	thread_pool *m_pool;
+	size_type m_position = 0;
+	::std::vector<detail::csv_chunk> m_chunks;
+	::std::vector<size_type> m_bounds;
+
+public:
+	explicit csv_reader(::std::string_view data, csv_options options = {},
+	                    thread_pool &pool = default_thread_pool()) :
+	    m_data{data}, m_options{options}, m_pool{&pool} {
+		if (m_options.batch_bytes == 0) {
+			m_options.batch_bytes = detail::csv_min_chunk * pool.size();
+		}
+	}
+
+
+	XTR_NODISCARD iterator begin() {
+		iterator result;
+		result.m_reader = this;
+		result.m_chunk = m_chunks.size();
+		advance(result);
+		return result;
+	}
+
+	XTR_NODISCARD iterator end() const noexcept {
+		return iterator{};
+	}
+
+private:
+	// Moves past exhausted chunks, parsing another batch when the current one runs out
+	void advance(iterator &position) {
+		for (;;) {
+			while (position.m_chunk < m_chunks.size()
+			       && position.m_row == m_chunks[position.m_chunk].m_row_ends.size()) {
+				++position.m_chunk;
+				position.m_row = 0;
+			}
+			if (position.m_chunk < m_chunks.size()) {
+				return;
+			}
+			if (!parse_batch()) {
+				position = iterator{};
+				return;
+			}
+			position.m_chunk = 0;
+			position.m_row = 0;
+		}
+	}
+
+	XTR_NODISCARD csv_row row(size_type chunk, size_type index) const noexcept {
+		const auto &source = m_chunks[chunk];
+		const auto first = index == 0 ? 0 : source.m_row_ends[index - 1];
+		return csv_row{source.m_fields.data() + first, source.m_row_ends[index] - first};
+	}
+
+	bool parse_batch() {
+		const auto remaining = m_data.size() - m_position;
+		if (remaining == 0) {
+			m_chunks.clear();
+			return false;
+		}
+		const char *const base = m_data.data() + m_position;
+		auto size = ::std::min({remaining, m_options.batch_bytes,
+		                        size_type{::std::numeric_limits<::std::uint32_t>::max()}});
+		size_type cut;
+		for (;;) {
+			index(base, size);
+			if (size == remaining) {
+				cut = size;
+				break;
+			}
+			// The batch ends after its last row, a row longer than the batch doubles it
+			const auto last = last_newline(base);
+			if (last) {
+				cut = *last + 1;
+				break;
+			}
+			size = ::std::min(remaining, size * 2);
+			if (size > ::std::numeric_limits<::std::uint32_t>::max()) {
+				throw ::std::length_error{"xtr::csv_reader: row longer than 4 GiB"};
+			}
+		}
+		m_pool->run(m_chunks.size(), [&](size_type chunk) { split_rows(base, chunk, cut); });
+		m_position += cut;
+		return true;
+	}
+
+	void index(const char *base, size_type size) {
+		const auto chunks = ::std::max<size_type>(
+		    1, ::std::min<size_type>(m_pool->size(), size / detail::csv_min_chunk));
+		m_chunks.resize(chunks);
+		m_bounds.resize(chunks + 1);
+		for (size_type chunk = 0; chunk <= chunks; ++chunk) {
+			m_bounds[chunk] = detail::parallel_block_begin(size, chunks, chunk);
+		}
+		const auto delimiter = m_options.delimiter;
+		const auto quote = m_options.quote;
+
+		// The last chunk is not counted, no chunk starts after it
+		::std::vector<unsigned char> inside(chunks, 0);
+		m_pool->run(chunks - 1, [&](size_type chunk) {
+			size_type count = 0;
+			detail::csv_scan(base + m_bounds[chunk], base + m_bounds[chunk + 1], delimiter, quote,
+			                 [&](const char *, ::std::uint64_t quotes, ::std::uint64_t) {
+				                 count += static_cast<size_type>(detail::popcount(quotes));
+			                 });
+			inside[chunk] = static_cast<unsigned char>(count & 1);
+		});
+		for (size_type chunk = 1; chunk < chunks; ++chunk) {
+			inside[chunk] ^= inside[chunk - 1];
+		}
+
+		m_pool->run(chunks, [&](size_type chunk) {
+			auto &separators = m_chunks[chunk].m_separators;
+			separators.clear();
+			separators.reserve((m_bounds[chunk + 1] - m_bounds[chunk]) / 16);
+			::std::uint64_t carry = chunk > 0 && inside[chunk - 1] != 0 ? ~::std::uint64_t{0} : 0;
+			detail::csv_scan(base + m_bounds[chunk], base + m_bounds[chunk + 1], delimiter, quote,
+			                 [&](const char *block, ::std::uint64_t quotes,
+			                     ::std::uint64_t candidates) {
+				                 const auto quoted = detail::prefix_xor(quotes) ^ carry;
+				                 carry = ::std::uint64_t{0} - (quoted >> 63);
+				                 auto bits = candidates & ~quoted;
+				                 const auto offset = static_cast<::std::uint32_t>(block - base);
+				                 const auto count = separators.size();
+				                 separators.resize(count + static_cast<size_type>(
+				                                               detail::popcount(bits)));
+				                 for (auto *output = separators.data() + count; bits != 0;
+				                      bits &= bits - 1) {
+					                 *output++ = offset
+					                             + static_cast<::std::uint32_t>(
+					                                 detail::countr_zero(bits));
+				                 }
+			                 });
+		});
+	}
+
+	XTR_NODISCARD ::std::optional<size_type> last_newline(const char *base) const noexcept {
+		for (auto chunk = m_chunks.size(); chunk-- > 0;) {
+			const auto &separators = m_chunks[chunk].m_separators;
+			for (auto it = separators.rbegin(); it != separators.rend(); ++it) {
+				if (base[*it] == '\n') {
+					return *it;
+				}
+			}
+		}
+		return ::std::nullopt;
+	}
+
+	// Splits the rows that start in a chunk, the last of which may end in a later chunk
+	void split_rows(const char *base, size_type chunk, size_type cut) {
+		auto &target = m_chunks[chunk];
+		target.m_fields.clear();
+		target.m_row_ends.clear();
+		target.m_fields.reserve(target.m_separators.size() + 1);
+
+		const auto *next = target.m_separators.data();
+		const auto *last = next + target.m_separators.size();
+		size_type field = 0;
+		if (chunk > 0) {
+			// A row starts at this chunk only after a newline ending the previous chunk
+			const auto &previous = m_chunks[chunk - 1].m_separators;
+			const auto begin = m_bounds[chunk];
+			if (previous.empty() || previous.back() != begin - 1 || base[begin - 1] != '\n') {
+				while (next != last && base[*next] != '\n') {
+					++next;
+				}
+				if (next == last) {
+					return;
+				}
+				field = *next++ + size_type{1};
+			}
+			else {
+				field = begin;
+			}
+		}
+
+		auto source = chunk;
+		const auto end = ::std::min(m_bounds[chunk + 1], cut);
+		for (auto row = field; row < end;) {
+			while (next == last && ++source < m_chunks.size()) {
+				next = m_chunks[source].m_separators.data();
+				last = next + m_chunks[source].m_separators.size();
+			}
+			const size_type separator = next != last ? *next++ : cut;
+			if (separator >= cut) {
+				// The last row of the input has no newline
+				add_field(target, base, field, cut, true);
+				end_row(target);
+				return;
+			}
+			const bool newline = base[separator] == '\n';
+			add_field(target, base, field, separator, newline);
+			field = separator + 1;
+			if (newline) {
+				end_row(target);
+				row = field;
+			}
+		}
+	}
+
+	void add_field(detail::csv_chunk &target, const char *base, size_type first, size_type last,
+	               bool row_end) const {
+		if (row_end && last > first && base[last - 1] == '\r') {
+			--last;
+		}
+		if (last - first >= 2 && base[first] == m_options.quote
+		    && base[last - 1] == m_options.quote) {
+			++first;
+			--last;
+		}
+		target.m_fields.emplace_back(base + first, last - first);
+	}
+
+	static void end_row(detail::csv_chunk &target) {
+		const auto first = target.m_row_ends.empty() ? 0 : target.m_row_ends.back();
+		if (target.m_fields.size() - first == 1 && target.m_fields.back().empty()) {
+			target.m_fields.pop_back();
+			return;
+		}
+		target.m_row_ends.push_back(target.m_fields.size());
+	}
+};
+
+
+namespace detail {
+
+inline csv_reader_iterator::reference csv_reader_iterator::operator*() const noexcept {
+	return m_reader->row(m_chunk, m_row);
+}
+
+inline csv_reader_iterator &csv_reader_iterator::operator++() {
+	++m_row;
+	m_reader->advance(*this);
+	return *this;
+}
+
+} // namespace detail
+
+} // namespace xtr
+
+#endif // XTR_CSV
+
+
+// JSON parsing in C++
+#if defined(XTR_JSON) && defined(__cplusplus)
+
+namespace xtr {
+
+enum class json_type { missing, null, boolean, number, string, array, object };
+
+class json_object;
+class json_array;
+class json_parser;
+
+namespace detail {
+
+inline constexpr ::std::size_t json_block_size = 64;
+
+struct json_token {
+	// Offset in the text of a bracket, colon, comma, opening quote or first byte of a literal
+	::std::uint32_t m_position;
+	// Number of tokens up to and including the end of the value starting here
+	::std::uint32_t m_size;
+};
+
+// Sets bit i of the masks when byte i of a 64 byte block is a quote, a backslash, one of the
+// operators {}[]:, or whitespace, which includes any other byte up to a space
+inline void json_classify(const char *block, ::std::uint64_t &quotes, ::std::uint64_t &backslashes,
+                          ::std::uint64_t &operators, ::std::uint64_t &whitespace) noexcept {
+	quotes = 0;
+	backslashes = 0;
+	operators = 0;
+	whitespace = 0;
+#if defined(XTR_SIMD_AVX2)
+	const auto quote_lanes = _mm256_set1_epi8('"');
+	const auto backslash_lanes = _mm256_set1_epi8('\\');
+	const auto open_lanes = _mm256_set1_epi8('{');
+	const auto close_lanes = _mm256_set1_epi8('}');
+	const auto colon_lanes = _mm256_set1_epi8(':');
+	const auto comma_lanes = _mm256_set1_epi8(',');
+	const auto space_lanes = _mm256_set1_epi8(' ');
+	for (int lane = 0; lane < 2; ++lane) {
+		const auto bytes =
+		    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + lane * 32));
+		// Setting bit 5 maps [ and ] onto { and }
+		const auto folded = _mm256_or_si256(bytes, space_lanes);
+		const auto operator_bytes = _mm256_or_si256(
+		    _mm256_or_si256(_mm256_cmpeq_epi8(folded, open_lanes),
+		                    _mm256_cmpeq_epi8(folded, close_lanes)),
+		    _mm256_or_si256(_mm256_cmpeq_epi8(bytes, colon_lanes),
+		                    _mm256_cmpeq_epi8(bytes, comma_lanes)));
+		const auto shift = lane * 32;
+		quotes |= ::std::uint64_t{static_cast<::std::uint32_t>(
+		              _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote_lanes)))}
+		          << shift;
+		backslashes |= ::std::uint64_t{static_cast<::std::uint32_t>(
+		                   _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, backslash_lanes)))}
+		               << shift;
+		operators |= ::std::uint64_t{static_cast<::std::uint32_t>(
+		                 _mm256_movemask_epi8(operator_bytes))}
+		             << shift;
+		whitespace |= ::std::uint64_t{static_cast<::std::uint32_t>(_mm256_movemask_epi8(
+		                  _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, space_lanes), bytes)))}
+		              << shift;
+	}
+#elif defined(XTR_SIMD_SSE2)
+	const auto quote_lanes = _mm_set1_epi8('"');
+	const auto backslash_lanes = _mm_set1_epi8('\\');
+	const auto open_lanes = _mm_set1_epi8('{');
+	const auto close_lanes = _mm_set1_epi8('}');
+	const auto colon_lanes = _mm_set1_epi8(':');
+	const auto comma_lanes = _mm_set1_epi8(',');
+	const auto space_lanes = _mm_set1_epi8(' ');
+	for (int lane = 0; lane < 4; ++lane) {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + lane * 16));
+		// Setting bit 5 maps [ and ] onto { and }
+		const auto folded = _mm_or_si128(bytes, space_lanes);
+		const auto operator_bytes =
+		    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open_lanes),
+		                              _mm_cmpeq_epi8(folded, close_lanes)),
+		                 _mm_or_si128(_mm_cmpeq_epi8(bytes, colon_lanes),
+		                              _mm_cmpeq_epi8(bytes, comma_lanes)));
+		const auto shift = lane * 16;
+		quotes |= ::std::uint64_t{static_cast<unsigned>(
+		              _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote_lanes)))}
+		          << shift;
+		backslashes |= ::std::uint64_t{static_cast<unsigned>(
+		                   _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash_lanes)))}
+		               << shift;
+		operators |= ::std::uint64_t{static_cast<unsigned>(_mm_movemask_epi8(operator_bytes))}
+		             << shift;
+		whitespace |= ::std::uint64_t{static_cast<unsigned>(_mm_movemask_epi8(
+		                  _mm_cmpeq_epi8(_mm_min_epu8(bytes, space_lanes), bytes)))}
+		              << shift;
+	}
+#else
+	for (::std::size_t i = 0; i < json_block_size; ++i) {
+		const auto byte = static_cast<unsigned char>(block[i]);
+		const auto folded = byte | 0x20u;
+		quotes |= ::std::uint64_t{byte == '"'} << i;
+		backslashes |= ::std::uint64_t{byte == '\\'} << i;
+		operators |= ::std::uint64_t{folded == '{' || folded == '}' || byte == ':' || byte == ','}
+		             << i;
+		whitespace |= ::std::uint64_t{byte <= ' '} << i;
+	}
+#endif
+}
+
+// Marks the bytes following a backslash that is not itself escaped, carry is set when the first
+// byte of the next block is escaped
+XTR_NODISCARD inline ::std::uint64_t json_escaped(::std::uint64_t backslashes,
+                                                  ::std::uint64_t &carry) noexcept {
+	auto escaped = carry;
+	backslashes &= ~carry;
+	carry = 0;
+	while (backslashes != 0) {
+		const auto bit = backslashes & (~backslashes + 1);
+		const auto next = bit << 1;
+		carry = next == 0 ? 1 : 0;
+		escaped |= next;
+		backslashes &= ~(bit | next);
+	}
+	return escaped;
+}
+
+// End of the value starting at token, before the whitespace in front of the token after it
+XTR_NODISCARD inline const char *json_value_end(const char *text,
+                                                const json_token *token) noexcept {
+	const char *last = text + token[token->m_size].m_position;
+	while (static_cast<unsigned char>(last[-1]) <= ' ') {
+		--last;
+	}
+	return last;
+}
+
+// Appends the UTF-8 encoding of a code point
+inline void json_append_utf8(::std::string &result, ::std::uint32_t code) {
+	if (code < 0x80) {
+		result += static_cast<char>(code);
+	}
+	else if (code < 0x800) {
+		result += static_cast<char>(0xC0 | (code >> 6));
+		result += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000) {
+		result += static_cast<char>(0xE0 | (code >> 12));
+		result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else {
+		result += static_cast<char>(0xF0 | (code >> 18));
+		result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+		result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (code & 0x3F));
+	}
+}
+
+// Reads the four hex digits of a \u escape starting at index
+XTR_NODISCARD inline ::std::optional<::std::uint32_t> json_hex4(::std::string_view text,
+                                                                ::std::size_t index) noexcept {
+	if (index > text.size() || text.size() - index < 4) {
+		return ::std::nullopt;
+	}
+	::std::uint32_t code = 0;
+	for (::std::size_t i = index; i < index + 4; ++i) {
+		const auto digit = static_cast<unsigned char>(text[i]);
+		code <<= 4;
+		if (digit >= '0' && digit <= '9') {
+			code |= digit - '0';
+		}
+		else if ((digit | 0x20u) >= 'a' && (digit | 0x20u) <= 'f') {
+			code |= (digit | 0x20u) - 'a' + 10;
+		}
+		else {
+			return ::std::nullopt;
+		}
+	}
+	return code;
+}
+
+// Decodes the escapes of a string without its quotes, runs without escapes are copied in bulk
+XTR_NODISCARD inline ::std::optional<::std::string> json_unescape(::std::string_view raw) {
+	::std::string result;
+	result.reserve(raw.size());
+	::std::size_t index = 0;
+	for (;;) {
+		const auto escape = raw.find('\\', index);
+		result.append(raw.data() + index, ::std::min(escape, raw.size()) - index);
+		if (escape == ::std::string_view::npos) {
+			return result;
+		}
+		if (escape + 1 == raw.size()) {
+			return ::std::nullopt;
+		}
+		index = escape + 2;
+		switch (raw[escape + 1]) {
+		case '"':
+		case '\\':
+		case '/':
+			result += raw[escape + 1];
+			break;
+		case 'b':
+			result += '\b';
+			break;
+		case 'f':
+			result += '\f';
+			break;
+		case 'n':
+			result += '\n';
+			break;
+		case 'r':
+			result += '\r';
+			break;
+		case 't':
+			result += '\t';
+			break;
+		case 'u': {
+			auto code = json_hex4(raw, index);
+			if (!code || (*code >= 0xDC00 && *code < 0xE000)) {
+				return ::std::nullopt;
+			}
+			index += 4;
+			// A high surrogate is followed by an escaped low surrogate
+			if (*code >= 0xD800 && *code < 0xDC00) {
+				if (raw.substr(index, 2) != "\\u") {
+					return ::std::nullopt;
+				}
+				const auto low = json_hex4(raw, index + 2);
+				if (!low || *low < 0xDC00 || *low >= 0xE000) {
+					return ::std::nullopt;
+				}
+				code = 0x10000 + ((*code - 0xD800) << 10) + (*low - 0xDC00);
+				index += 6;
+			}
+			json_append_utf8(result, *code);
+			break;
+		}
+		default:
+			return ::std::nullopt;
+		}
+	}
+}
+
+// Compares a string without its quotes to a key, only decoding it when it has escapes
+XTR_NODISCARD inline bool json_key_equals(::std::string_view raw, ::std::string_view key) {
+	if (raw.size() < key.size()) {
+		return false;
+	}
+	if (raw.find('\\') == ::std::string_view::npos) {
+		return raw == key;
+	}
+	const auto decoded = json_unescape(raw);
+	return decoded && *decoded == key;
+}
+
+// Checks the number grammar, which is stricter than std::from_chars about leading zeros, missing
+// digits, and words such as inf and nan
+XTR_NODISCARD inline bool json_is_number(::std::string_view raw) noexcept {
+	const char *first = raw.data();
+	const char *last = first + raw.size();
+	const auto digits = [&] {
+		const char *start = first;
+		while (first != last && *first >= '0' && *first <= '9') {
+			++first;
+		}
+		return first - start;
+	};
+	if (first != last && *first == '-') {
+		++first;
+	}
+	const char *integer = first;
+	const auto integer_digits = digits();
+	if (integer_digits == 0 || (integer_digits > 1 && *integer == '0')) {
+		return false;
+	}
+	if (first != last && *first == '.') {
+		++first;
+		if (digits() == 0) {
+			return false;
+		}
+	}
+	if (first != last && (*first == 'e' || *first == 'E')) {
+		++first;
+		if (first != last && (*first == '+' || *first == '-')) {
+			++first;
+		}
+		if (digits() == 0) {
+			return false;
+		}
+	}
+	return first == last;
+}
+
+template <typename T>
+XTR_NODISCARD ::std::optional<T> json_number(::std::string_view raw) noexcept {
+	if (!json_is_number(raw)) {
+		return ::std::nullopt;
+	}
+	T result;
+	const auto last = raw.data() + raw.size();
+	const auto parsed = ::std::from_chars(raw.data(), last, result);
+	if (parsed.ec != ::std::errc{} || parsed.ptr != last) {
+		return ::std::nullopt;
+	}
+	return result;
+}
+
+#if !defined(__cpp_lib_to_chars)
+// Floating point std::from_chars is missing, strtod needs a terminated copy
+template <>
+XTR_NODISCARD inline ::std::optional<double> json_number<double>(::std::string_view raw) noexcept {
+	if (!json_is_number(raw)) {
+		return ::std::nullopt;
+	}
+	char buffer[64];
+	if (raw.size() >= sizeof(buffer)) {
+		return ::std::nullopt;
+	}
+	::std::memcpy(buffer, raw.data(), raw.size());
+	buffer[raw.size()] = '\0';
+	char *last;
+	const double result = ::std::strtod(buffer, &last);
+	if (last != buffer + raw.size()) {
+		return ::std::nullopt;
+	}
+	return result;
+}
+#endif
+
+} // namespace detail
+
+
+// Lazy reference to a value in a document indexed by json_parser. Values that are looked up but
+// not found are missing, and reading one as any type gives std::nullopt, so lookups can be chained
+class json_value {
+	const char *m_text = nullptr;
+	const detail::json_token *m_token = nullptr;
+
+public:
+	json_value() noexcept = default;
+
+	json_value(const char *text, const detail::json_token *token) noexcept :
+	    m_text{text}, m_token{token} {}
+
+
+	XTR_NODISCARD bool exists() const noexcept {
+		return m_token != nullptr;
+	}
+
+	// Numbers and literals are only checked when they are read
+	XTR_NODISCARD json_type type() const noexcept {
+		if (!m_token) {
+			return json_type::missing;
+		}
+		switch (m_text[m_token->m_position]) {
+		case '{':
+			return json_type::object;
+		case '[':
+			return json_type::array;
+		case '"':
+			return json_type::string;
+		case 't':
+		case 'f':
+			return json_type::boolean;
+		case 'n':
+			return json_type::null;
+		default:
+			return json_type::number;
+		}
+	}
+
+	// Text of the value, including quotes and brackets
+	XTR_NODISCARD ::std::string_view raw() const noexcept {
+		if (!m_token) {
+			return {};
+		}
+		const char *first = m_text + m_token->m_position;
+		return {first, static_cast<::std::size_t>(detail::json_value_end(m_text, m_token) - first)};
+	}
+
+	XTR_NODISCARD bool is_null() const noexcept {
+		return m_token && raw() == "null";
+	}
+
+	XTR_NODISCARD ::std::optional<bool> as_bool() const noexcept {
+		const auto text = raw();
+		if (text == "true") {
+			return true;
+		}
+		if (text == "false") {
+			return false;
+		}
+		return ::std::nullopt;
+	}
+
+	XTR_NODISCARD ::std::optional<::std::int64_t> as_int64() const noexcept {
+		return type() == json_type::number ? detail::json_number<::std::int64_t>(raw())
+		                                   : ::std::nullopt;
+	}
+
+	XTR_NODISCARD ::std::optional<::std::uint64_t> as_uint64() const noexcept {
+		return type() == json_type::number ? detail::json_number<::std::uint64_t>(raw())
+		                                   : ::std::nullopt;
+	}
+
+	XTR_NODISCARD ::std::optional<double> as_double() const noexcept {
+		return type() == json_type::number ? detail::json_number<double>(raw()) : ::std::nullopt;
+	}
+
+	// Text of a string between its quotes, with escapes left in place
+	XTR_NODISCARD ::std::optional<::std::string_view> as_raw_string() const noexcept {
+		if (type() != json_type::string) {
+			return ::std::nullopt;
+		}
+		const auto text = raw();
+		return text.substr(1, text.size() - 2);
+	}
+
+	XTR_NODISCARD ::std::optional<::std::string> as_string() const {
+		const auto text = as_raw_string();
+		return text ? detail::json_unescape(*text) : ::std::nullopt;
+	}
+
+	// Fields of an object, which are empty for other types
+	XTR_NODISCARD inline json_object fields() const noexcept;
+
+	// Elements of an array, which are empty for other types
+	XTR_NODISCARD inline json_array elements() const noexcept;
+
+	// First field of an object with the key, skipping the values of other fields without
+	// looking inside them
+	XTR_NODISCARD inline json_value operator[](::std::string_view key) const;
+
+	XTR_NODISCARD inline json_value operator[](::std::size_t index) const noexcept;
+};
+
+
+// Key without quotes, with escapes left in place
+struct json_field {
+	::std::string_view key;
+	json_value value;
+};
+
+
+namespace detail {
+
+class json_field_iterator {
+public:
+	using iterator_category = ::std::forward_iterator_tag;
+	using value_type = json_field;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = void;
+	using reference = json_field;
+
+	const char *m_text = nullptr;
+	// Key of the current field, or null at the end
+	const json_token *m_key = nullptr;
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		const char *first = m_text + m_key->m_position + 1;
+		const auto size = static_cast<::std::size_t>(json_value_end(m_text, m_key) - first) - 1;
+		return {{first, size}, json_value{m_text, m_key + 2}};
+	}
+
+	json_field_iterator &operator++() noexcept {
+		const auto value = m_key + 2;
+		const auto after = value + value->m_size;
+		m_key = m_text[after->m_position] == ',' ? after + 1 : nullptr;
+		return *this;
+	}
+
+	json_field_iterator operator++(int) noexcept {
+		auto result = *this;
+		++*this;
+		return result;
+	}
+
+	XTR_NODISCARD friend bool operator==(const json_field_iterator &left,
+	                                     const json_field_iterator &right) noexcept {
+		return left.m_key == right.m_key;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const json_field_iterator &left,
+	                                     const json_field_iterator &right) noexcept {
+		return !(left == right);
+	}
+};
+
+class json_element_iterator {
+public:
+	using iterator_category = ::std::forward_iterator_tag;
+	using value_type = json_value;
+	using difference_type = ::std::ptrdiff_t;
+	using pointer = void;
+	using reference = json_value;
+
+	const char *m_text = nullptr;
+	// Current element, or null at the end
+	const json_token *m_element = nullptr;
+
+
+	XTR_NODISCARD reference operator*() const noexcept {
+		return json_value{m_text, m_element};
+	}
+
+	json_element_iterator &operator++() noexcept {
+		const auto after = m_element + m_element->m_size;
+		m_element = m_text[after->m_position] == ',' ? after + 1 : nullptr;
+		return *this;
+	}
+
+	json_element_iterator operator++(int) noexcept {
+		auto result = *this;
+		++*this;
+		return result;
+	}
+
+	XTR_NODISCARD friend bool operator==(const json_element_iterator &left,
+	                                     const json_element_iterator &right) noexcept {
+		return left.m_element == right.m_element;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const json_element_iterator &left,
+	                                     const json_element_iterator &right) noexcept {
+		return !(left == right);
+	}
+};
+
+} // namespace detail
+
+
+class json_object {
+public:
+	using value_type = json_field;
+	using size_type = ::std::size_t;
+	using iterator = detail::json_field_iterator;
+	using const_iterator = iterator;
+
+private:
+	iterator m_begin;
+
+public:
+	json_object() noexcept = default;
+
+	explicit json_object(iterator first) noexcept : m_begin{first} {}
+
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_begin.m_key == nullptr;
+	}
+
+	XTR_NODISCARD const_iterator begin() const noexcept {
+		return m_begin;
+	}
+
+	XTR_NODISCARD const_iterator end() const noexcept {
+		return iterator{m_begin.m_text, nullptr};
+	}
+};
+
+
+class json_array {
+public:
+	using value_type = json_value;
+	using size_type = ::std::size_t;
+	using iterator = detail::json_element_iterator;
+	using const_iterator = iterator;
+
+private:
+	iterator m_begin;
+
+public:
+	json_array() noexcept = default;
+
+	explicit json_array(iterator first) noexcept : m_begin{first} {}
+
+
+	XTR_NODISCARD bool empty() const noexcept {
+		return m_begin.m_element == nullptr;
+	}
+
+	XTR_NODISCARD const_iterator begin() const noexcept {
+		return m_begin;
+	}
+
+	XTR_NODISCARD const_iterator end() const noexcept {
+		return iterator{m_begin.m_text, nullptr};
+	}
+};
+
+
+json_object json_value::fields() const noexcept {
+	if (type() != json_type::object || m_token->m_size == 2) {
+		return json_object{};
+	}
+	return json_object{detail::json_field_iterator{m_text, m_token + 1}};
+}
+
+json_array json_value::elements() const noexcept {
+	if (type() != json_type::array || m_token->m_size == 2) {
+		return json_array{};
+	}
+	return json_array{detail::json_element_iterator{m_text, m_token + 1}};
+}
+
+json_value json_value::operator[](::std::string_view key) const {
+	for (const auto &field : fields()) {
+		if (detail::json_key_equals(field.key, key)) {
+			return field.value;
+		}
+	}
+	return json_value{};
+}
+
+json_value json_value::operator[](::std::size_t index) const noexcept {
+	for (const auto &element : elements()) {
+		if (index-- == 0) {
+			return element;
+		}
+	}
+	return json_value{};
+}
+
+
+// Indexes JSON text without building a tree. The first stage classifies 64 bytes at a time with
+// SIMD and records the offsets of brackets, colons, commas, strings and literals outside strings.
+// The second stage checks the structure and links each bracket to its match, so values that are
+// not read are skipped in constant time
+class json_parser {
+	::std::string_view m_text;
+	// Tokens of the document followed by one at the end of the text, the vector only grows so
+	// that later documents reuse it without initializing it again
+	::std::vector<detail::json_token> m_tokens;
+	::std::size_t m_count = 0;
+	::std::vector<::std::uint32_t> m_open;
+
+public:
+	// Returns the root value, or std::nullopt when brackets, strings, colons or commas are out of
+	// place. Values reference the text and stay valid until the next parse
+	XTR_NODISCARD ::std::optional<json_value> parse(::std::string_view text) {
+		if (text.size() >= ::std::numeric_limits<::std::uint32_t>::max()) {
+			throw ::std::length_error{"xtr::json_parser: text longer than 4 GiB"};
+		}
+		m_text = text;
+		if (!index() || !link()) {
+			return ::std::nullopt;
+		}
+		return json_value{m_text.data(), m_tokens.data()};
+	}
+
+private:
+	// Records the token offsets, returns false for an unterminated string
+	bool index() {
+		::std::size_t count = 0;
+		::std::uint64_t escape_carry = 0;
+		::std::uint64_t string_carry = 0;
+		::std::uint64_t literal_carry = 0;
+		const auto emit = [&](::std::size_t offset, const char *block, ::std::uint64_t mask) {
+			::std::uint64_t quotes;
+			::std::uint64_t backslashes;
+			::std::uint64_t operators;
+			::std::uint64_t whitespace;
+			detail::json_classify(block, quotes, backslashes, operators, whitespace);
+			quotes &= ~detail::json_escaped(backslashes, escape_carry);
+			// Set from an opening quote up to the byte before the closing quote
+			const auto strings = detail::prefix_xor(quotes) ^ string_carry;
+			string_carry = ::std::uint64_t{0} - (strings >> 63);
+			const auto outside = ~(strings | quotes);
+			operators &= outside;
+			const auto literals = ~(operators | whitespace | quotes) & outside;
+			const auto starts = literals & ~((literals << 1) | literal_carry);
+			literal_carry = literals >> 63;
+			auto bits = (operators | (quotes & strings) | starts) & mask;
+
+			// Room for a whole block of tokens and the one at the end
+			if (m_tokens.size() <= count + detail::json_block_size) {
+				m_tokens.resize(
+				    ::std::max(count + detail::json_block_size + 1, m_tokens.size() * 2));
+			}
+			const auto tokens = m_tokens.data() + count;
+			const auto found = detail::popcount(bits);
+			for (int i = 0; i < found; ++i) {
+				const auto bit = static_cast<::std::size_t>(detail::countr_zero(bits));
+				tokens[i].m_position = static_cast<::std::uint32_t>(offset + bit);
+				bits &= bits - 1;
+			}
+			count += static_cast<::std::size_t>(found);
+		};
+
+		const auto size = m_text.size();
+		::std::size_t offset = 0;
+		for (; size - offset >= detail::json_block_size; offset += detail::json_block_size) {
+			emit(offset, m_text.data() + offset, ~::std::uint64_t{0});
+		}
+		if (offset != size) {
+			char block[detail::json_block_size] = {};
+			::std::memcpy(block, m_text.data() + offset, size - offset);
+			emit(offset, block, (::std::uint64_t{1} << (size - offset)) - 1);
+		}
+		if (m_tokens.size() == count) {
+			m_tokens.resize(count + 1);
+		}
+		m_tokens[count] = {static_cast<::std::uint32_t>(size), 0};
+		m_count = count;
+		return string_carry == 0;
+	}
+
+	// Checks the grammar of the tokens and sets the size of each value, returns false when it
+	// does not match
+	bool link() {
+		enum class state { value, first_element, key, first_key, colon, after_value };
+		auto expect = state::value;
+		m_open.clear();
+		const auto close = [&](::std::uint32_t index) {
+			auto &open = m_tokens[m_open.back()];
+			open.m_size = index + 1 - m_open.back();
+			m_open.pop_back();
+			expect = state::after_value;
+		};
+
+		const auto count = static_cast<::std::uint32_t>(m_count);
+		for (::std::uint32_t index = 0; index < count; ++index) {
+			const char token = m_text[m_tokens[index].m_position];
+			m_tokens[index].m_size = 1;
+			switch (expect) {
+			case state::after_value: {
+				// Only the root value is allowed outside brackets
+				if (m_open.empty()) {
+					return false;
+				}
+				const char open = m_text[m_tokens[m_open.back()].m_position];
+				if (token == ',') {
+					expect = open == '{' ? state::key : state::value;
+				}
+				else if (token == open + 2) {
+					close(index);
+				}
+				else {
+					return false;
+				}
+				break;
+			}
+			case state::colon:
+				if (token != ':') {
+					return false;
+				}
+				expect = state::value;
+				break;
+			case state::first_key:
+			case state::key:
+				if (token == '"') {
+					expect = state::colon;
+				}
+				else if (token == '}' && expect == state::first_key) {
+					close(index);
+				}
+				else {
+					return false;
+				}
+				break;
+			case state::first_element:
+			case state::value:
+				switch (token) {
+				case '{':
+					m_open.push_back(index);
+					expect = state::first_key;
+					break;
+				case '[':
+					m_open.push_back(index);
+					expect = state::first_element;
+					break;
+				case ']':
+					if (expect != state::first_element) {
+						return false;
+					}
+					close(index);
+					break;
+				case '}':
+				case ':':
+				case ',':
+					return false;
+				default:
+					expect = state::after_value;
+				}
+				break;
+			}
+		}
+		return expect == state::after_value && m_open.empty();
+	}
+};
+
+} // namespace xtr
+
+#endif // XTR_JSON
+
+
+// Random number generation in C++
+#if defined(XTR_RANDOM) && defined(__cplusplus)
+
+namespace xtr {
+
+namespace detail {
+
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::uint64_t rotate_left(::std::uint64_t value,
+                                                               int shift) noexcept {
+	return (value << shift) | (value >> (64 - shift));
+}
+
+#if defined(XTR_SIMD_AVX2)
+template <int Shift>
+XTR_NODISCARD inline __m256i rotate_left(__m256i value) noexcept {
+	return _mm256_or_si256(_mm256_slli_epi64(value, Shift), _mm256_srli_epi64(value, 64 - Shift));
+}
+
+// One xoshiro256++ step of four lanes
+XTR_NODISCARD inline __m256i xoshiro_step(__m256i &s0, __m256i &s1, __m256i &s2,
+                                          __m256i &s3) noexcept {
+	const auto result = _mm256_add_epi64(rotate_left<23>(_mm256_add_epi64(s0, s3)), s0);
+	const auto shifted = _mm256_slli_epi64(s1, 17);
+	s2 = _mm256_xor_si256(s2, s0);
+	s3 = _mm256_xor_si256(s3, s1);
+	s1 = _mm256_xor_si256(s1, s2);
+	s0 = _mm256_xor_si256(s0, s3);
+	s2 = _mm256_xor_si256(s2, shifted);
+	s3 = rotate_left<45>(s3);
+	return result;
+}
+#elif defined(XTR_SIMD_SSE2)
+template <int Shift>
+XTR_NODISCARD inline __m128i rotate_left(__m128i value) noexcept {
+	return _mm_or_si128(_mm_slli_epi64(value, Shift), _mm_srli_epi64(value, 64 - Shift));
+}
+
+// One xoshiro256++ step of two lanes
+XTR_NODISCARD inline __m128i xoshiro_step(__m128i &s0, __m128i &s1, __m128i &s2,
+                                          __m128i &s3) noexcept {
+	const auto result = _mm_add_epi64(rotate_left<23>(_mm_add_epi64(s0, s3)), s0);
+	const auto shifted = _mm_slli_epi64(s1, 17);
+	s2 = _mm_xor_si128(s2, s0);
+	s3 = _mm_xor_si128(s3, s1);
+	s1 = _mm_xor_si128(s1, s2);
+	s0 = _mm_xor_si128(s0, s3);
+	s2 = _mm_xor_si128(s2, shifted);
+	s3 = rotate_left<45>(s3);
+	return result;
+}
+#endif
+
+XTR_NODISCARD inline XTR_CONSTEXPR ::std::uint64_t splitmix64(::std::uint64_t &state) noexcept {
+	auto value = state += 0x9E3779B97F4A7C15u;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9u;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBu;
+	return value ^ (value >> 31);
+}
+
+// Jump polynomials advancing xoshiro256 by 2^128 and 2^192 steps
+inline constexpr ::std::uint64_t xoshiro_jump[4] = {0x180EC6D33CFD0ABAu, 0xD5A61266F0C9392Cu,
+                                                    0xA9582618E03FC9AAu, 0x39ABDC4529B1661Cu};
+inline constexpr ::std::uint64_t xoshiro_long_jump[4] = {
+    0x76E15D3EFEFDCBBFu, 0xC5004E441C522FB3u, 0x77710069854EE241u, 0x39109BB02ACBE635u};
+
+} // namespace detail
+
+
+// The xoshiro256++ generator by Blackman and Vigna, which passes BigCrush and is several times
+// faster than std::mt19937_64 with 32 bytes of state. Meets the UniformRandomBitGenerator
+// requirements for use with the standard distributions
+class xoshiro256pp {
+public:
+	using result_type = ::std::uint64_t;
+
+private:
+	::std::array<::std::uint64_t, 4> m_state;
+
+public:
+	// Expands the seed with splitmix64 so that similar seeds give unrelated states
+	explicit xoshiro256pp(::std::uint64_t seed = 0) noexcept {
+		for (auto &word : m_state) {
+			word = detail::splitmix64(seed);
+		}
+	}
+
+	// The state must not be all zero
+	explicit xoshiro256pp(const ::std::array<::std::uint64_t, 4> &state) noexcept :
+	    m_state{state} {
+		assert(state[0] != 0 || state[1] != 0 || state[2] != 0 || state[3] != 0);
+	}
+
+
+	XTR_NODISCARD static XTR_CONSTEXPR result_type min() noexcept {
+		return 0;
+	}
+
+	XTR_NODISCARD static XTR_CONSTEXPR result_type max() noexcept {
+		return ::std::numeric_limits<result_type>::max();
+	}
+
+	XTR_NODISCARD const ::std::array<::std::uint64_t, 4> &state() const noexcept {
+		return m_state;
+	}
+
+	result_type operator()() noexcept {
+		auto &state = m_state;
+		const auto result = detail::rotate_left(state[0] + state[3], 23) + state[0];
+		const auto shifted = state[1] << 17;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= shifted;
+		state[3] = detail::rotate_left(state[3], 45);
+		return result;
+	}
+
+	void fill(::std::uint64_t *data, ::std::size_t count) noexcept {
+		for (::std::size_t i = 0; i < count; ++i) {
+			data[i] = (*this)();
+		}
+	}
+
+	void discard(unsigned long long count) noexcept {
+		for (; count > 0; --count) {
+			static_cast<void>((*this)());
+		}
+	}
+
+	// Advances by 2^128 steps, giving up to 2^128 streams that never overlap
+	void jump() noexcept {
+		jump(detail::xoshiro_jump);
+	}
+
+	// Advances by 2^192 steps, giving up to 2^64 starting points that each have room for 2^64
+	// calls to jump
+	void long_jump() noexcept {
+		jump(detail::xoshiro_long_jump);
+	}
+
+	XTR_NODISCARD friend bool operator==(const xoshiro256pp &left,
+	                                     const xoshiro256pp &right) noexcept {
+		return left.m_state == right.m_state;
+	}
+
+	XTR_NODISCARD friend bool operator!=(const xoshiro256pp &left,
+	                                     const xoshiro256pp &right) noexcept {
+		return !(left == right);
+	}
+
+private:
+	void jump(const ::std::uint64_t (&polynomial)[4]) noexcept {
+		::std::array<::std::uint64_t, 4> result = {};
+		for (const auto word : polynomial) {
+			for (int bit = 0; bit < 64; ++bit) {
+				if ((word >> bit) & 1) {
+					for (::std::size_t i = 0; i < 4; ++i) {
+						result[i] ^= m_state[i];
+					}
+				}
+				static_cast<void>((*this)());
+			}
+		}
+		m_state = result;
+	}
+};
+
+
+// Eight xoshiro256++ generators spaced 2^128 steps apart and advanced together with SIMD, whose
+// outputs are interleaved. The sequence is the same with and without instruction set extensions
+class xoshiro256pp_simd {
+public:
+	using result_type = ::std::uint64_t;
+
+	static constexpr ::std::size_t lanes = 8;
+
+private:
+	// Word i of the state of every lane is stored together
+	alignas(32) ::std::uint64_t m_state[4][lanes];
+	::std::uint64_t m_buffer[lanes];
+	::std::size_t m_next = lanes;
+
+public:
+	explicit xoshiro256pp_simd(::std::uint64_t seed = 0) noexcept {
+		xoshiro256pp generator{seed};
+		for (::std::size_t lane = 0; lane < lanes; ++lane) {
+			for (int i = 0; i < 4; ++i) {
+				m_state[i][lane] = generator.state()[static_cast<::std::size_t>(i)];
+			}
+			generator.jump();
+		}
+	}
+
+
+	XTR_NODISCARD static XTR_CONSTEXPR result_type min() noexcept {
+		return 0;
+	}
+
+	XTR_NODISCARD static XTR_CONSTEXPR result_type max() noexcept {
+		return ::std::numeric_limits<result_type>::max();
+	}
+
+	result_type operator()() noexcept {
+		if (m_next == lanes) {
+			generate(m_buffer, 1);
+			m_next = 0;
+		}
+		return m_buffer[m_next++];
+	}
+
+	// Writes whole blocks of one value per lane straight to data
+	void fill(::std::uint64_t *data, ::std::size_t count) noexcept {
+		for (; count > 0 && m_next < lanes; --count) {
+			*data++ = m_buffer[m_next++];
+		}
+		const auto blocks = count / lanes;
+		generate(data, blocks);
+		data += blocks * lanes;
+		count -= blocks * lanes;
+		for (; count > 0; --count) {
+			*data++ = (*this)();
+		}
+	}
+
+	// Advances every lane by 2^192 steps, so copies that are jumped different numbers of times
+	// can be given to separate threads
+	void long_jump() noexcept {
+		for (::std::size_t lane = 0; lane < lanes; ++lane) {
+			xoshiro256pp generator{{m_state[0][lane], m_state[1][lane], m_state[2][lane],
+			                        m_state[3][lane]}};
+			generator.long_jump();
+			for (int i = 0; i < 4; ++i) {
+				m_state[i][lane] = generator.state()[static_cast<::std::size_t>(i)];
+			}
+		}
+	}
+
+private:
+	void generate(::std::uint64_t *data, ::std::size_t blocks) noexcept {
+#if defined(XTR_SIMD_AVX2)
+		// Two independent sets of registers keep more instructions in flight
+		const auto load = [this](int word, ::std::size_t lane) {
+			return _mm256_load_si256(reinterpret_cast<const __m256i *>(m_state[word] + lane));
+		};
+		auto a0 = load(0, 0);
+		auto a1 = load(1, 0);
+		auto a2 = load(2, 0);
+		auto a3 = load(3, 0);
+		auto b0 = load(0, 4);
+		auto b1 = load(1, 4);
+		auto b2 = load(2, 4);
+		auto b3 = load(3, 4);
+		for (::std::size_t block = 0; block < blocks; ++block, data += lanes) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(data),
+			                    detail::xoshiro_step(a0, a1, a2, a3));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(data + 4),
+			                    detail::xoshiro_step(b0, b1, b2, b3));
+		}
+		const auto store = [this](int word, ::std::size_t lane, __m256i value) {
+			_mm256_store_si256(reinterpret_cast<__m256i *>(m_state[word] + lane), value);
+		};
+		store(0, 0, a0);
+		store(1, 0, a1);
+		store(2, 0, a2);
+		store(3, 0, a3);
+		store(0, 4, b0);
+		store(1, 4, b1);
+		store(2, 4, b2);
+		store(3, 4, b3);
+#elif defined(XTR_SIMD_SSE2)
+		const auto load = [this](int word, ::std::size_t lane) {
+			return _mm_load_si128(reinterpret_cast<const __m128i *>(m_state[word] + lane));
+		};
+		const auto store = [this](int word, ::std::size_t lane, __m128i value) {
+			_mm_store_si128(reinterpret_cast<__m128i *>(m_state[word] + lane), value);
+		};
+		// Four lanes at a time in two independent sets of registers fit in the 16 registers
+		for (::std::size_t group = 0; group < lanes; group += 4) {
+			auto a0 = load(0, group);
+			auto a1 = load(1, group);
+			auto a2 = load(2, group);
+			auto a3 = load(3, group);
+			auto b0 = load(0, group + 2);
+			auto b1 = load(1, group + 2);
+			auto b2 = load(2, group + 2);
+			auto b3 = load(3, group + 2);
+			auto *output = data + group;
+			for (::std::size_t block = 0; block < blocks; ++block, output += lanes) {
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(output),
+				                 detail::xoshiro_step(a0, a1, a2, a3));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(output + 2),
+				                 detail::xoshiro_step(b0, b1, b2, b3));
+			}
+			store(0, group, a0);
+			store(1, group, a1);
+			store(2, group, a2);
+			store(3, group, a3);
+			store(0, group + 2, b0);
+			store(1, group + 2, b1);
+			store(2, group + 2, b2);
+			store(3, group + 2, b3);
+		}
+#else
+		auto &s0 = m_state[0];
+		auto &s1 = m_state[1];
+		auto &s2 = m_state[2];
+		auto &s3 = m_state[3];
+		for (::std::size_t block = 0; block < blocks; ++block) {
+			for (::std::size_t lane = 0; lane < lanes; ++lane) {
+				data[block * lanes + lane] =
+				    detail::rotate_left(s0[lane] + s3[lane], 23) + s0[lane];
+				const auto shifted = s1[lane] << 17;
+				s2[lane] ^= s0[lane];
+				s3[lane] ^= s1[lane];
+				s1[lane] ^= s2[lane];
+				s0[lane] ^= s3[lane];
+				s2[lane] ^= shifted;
+				s3[lane] = detail::rotate_left(s3[lane], 45);
+			}
+		}
+#endif
+	}
+};
+
+
+namespace detail {
+
+// Random values are generated in chunks of raw bits that stay in L1
+inline constexpr ::std::size_t random_chunk = 256;
+
+template <typename Generator, typename = void>
+struct has_random_fill : ::std::false_type {};
+
+template <typename Generator>
+struct has_random_fill<Generator,
+                       ::std::void_t<decltype(::std::declval<Generator &>().fill(
+                           ::std::declval<::std::uint64_t *>(), ::std::size_t{}))>> :
+    ::std::true_type {};
+
+template <typename Generator>
+void random_fill(Generator &generator, ::std::uint64_t *data, ::std::size_t count) {
+	static_assert(Generator::min() == 0
+	                  && Generator::max() == ::std::numeric_limits<::std::uint64_t>::max(),
+	              "Generator must produce 64 random bits per call");
+	if constexpr (has_random_fill<Generator>::value) {
+		generator.fill(data, count);
+	}
+	else {
+		for (::std::size_t i = 0; i < count; ++i) {
+			data[i] = generator();
+		}
+	}
+}
+
+// Arithmetic type stored in a range or nested ranges such as multiarray, missing for other types
+template <typename Type, typename = void>
+struct random_value {};
+
+template <typename Type>
+struct random_value<Type, ::std::enable_if_t<::std::is_arithmetic_v<Type>>> {
+	using type = Type;
+};
+
+template <typename Range>
+struct random_value<Range, ::std::void_t<decltype(::std::data(::std::declval<Range &>()))>> :
+    random_value<::std::remove_cv_t<
+        ::std::remove_pointer_t<decltype(::std::data(::std::declval<Range &>()))>>> {};
+
+template <typename Type>
+using random_value_t = typename random_value<::std::remove_reference_t<Type>>::type;
+
+// Calls function(data, count) for each innermost contiguous row of a range
+template <typename Range, typename Function>
+void random_for_each_row(Range &range, Function &function) {
+	const auto data = ::std::data(range);
+	const auto size = static_cast<::std::size_t>(::std::size(range));
+	if constexpr (::std::is_arithmetic_v<::std::remove_pointer_t<decltype(data)>>) {
+		function(data, size);
+	}
+	else {
+		for (::std::size_t i = 0; i < size; ++i) {
+			random_for_each_row(data[i], function);
+		}
+	}
+}
+
+// Uniform in [0, 1) with 52 random bits, made by setting the bits below the exponent of 1.0
+XTR_NODISCARD inline double random_unit(::std::uint64_t bits) noexcept {
+	const auto pattern = (bits >> 12) | 0x3FF0000000000000u;
+	double result;
+	::std::memcpy(&result, &pattern, sizeof(result));
+	return result - 1.0;
+}
+
+XTR_NODISCARD inline float random_unit_float(::std::uint32_t bits) noexcept {
+	const auto pattern = (bits >> 9) | 0x3F800000u;
+	float result;
+	::std::memcpy(&result, &pattern, sizeof(result));
+	return result - 1.0f;
+}
+
+// Maps bits to [low, low + scale) in bulk, several values at a time with SIMD
+// Rounding can carry low + scale * unit up to high, so values are clamped to limit, the largest
+// value below high
+inline void random_uniform_values(const ::std::uint64_t *bits, double *data, ::std::size_t count,
+                                  double low, double scale, double limit) noexcept {
+	::std::size_t i = 0;
+#if defined(XTR_SIMD_AVX2)
+	const auto exponent = _mm256_set1_epi64x(0x3FF0000000000000);
+	const auto one = _mm256_set1_pd(1.0);
+	const auto low_lanes = _mm256_set1_pd(low);
+	const auto scale_lanes = _mm256_set1_pd(scale);
+	const auto limit_lanes = _mm256_set1_pd(limit);
+	for (; i + 4 <= count; i += 4) {
+		const auto pattern = _mm256_or_si256(
+		    _mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bits + i)), 12),
+		    exponent);
+		const auto unit = _mm256_sub_pd(_mm256_castsi256_pd(pattern), one);
+		const auto value = _mm256_add_pd(low_lanes, _mm256_mul_pd(scale_lanes, unit));
+		_mm256_storeu_pd(data + i, _mm256_min_pd(value, limit_lanes));
+	}
+#elif defined(XTR_SIMD_SSE2)
+	const auto exponent = _mm_set1_epi64x(0x3FF0000000000000);
+	const auto one = _mm_set1_pd(1.0);
+	const auto low_lanes = _mm_set1_pd(low);
+	const auto scale_lanes = _mm_set1_pd(scale);
+	const auto limit_lanes = _mm_set1_pd(limit);
+	for (; i + 2 <= count; i += 2) {
+		const auto pattern = _mm_or_si128(
+		    _mm_srli_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bits + i)), 12),
+		    exponent);
+		const auto unit = _mm_sub_pd(_mm_castsi128_pd(pattern), one);
+		const auto value = _mm_add_pd(low_lanes, _mm_mul_pd(scale_lanes, unit));
+		_mm_storeu_pd(data + i, _mm_min_pd(value, limit_lanes));
+	}
+#endif
+	for (; i < count; ++i) {
+		data[i] = ::std::min(low + scale * random_unit(bits[i]), limit);
+	}
+}
+
+inline void random_uniform_values(const ::std::uint32_t *bits, float *data, ::std::size_t count,
+                                  float low, float scale, float limit) noexcept {
+	::std::size_t i = 0;
+#if defined(XTR_SIMD_AVX2)
+	const auto exponent = _mm256_set1_epi32(0x3F800000);
+	const auto one = _mm256_set1_ps(1.0f);
+	const auto low_lanes = _mm256_set1_ps(low);
+	const auto scale_lanes = _mm256_set1_ps(scale);
+	const auto limit_lanes = _mm256_set1_ps(limit);
+	for (; i + 8 <= count; i += 8) {
+		const auto pattern = _mm256_or_si256(
+		    _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bits + i)), 9),
+		    exponent);
+		const auto unit = _mm256_sub_ps(_mm256_castsi256_ps(pattern), one);
+		const auto value = _mm256_add_ps(low_lanes, _mm256_mul_ps(scale_lanes, unit));
+		_mm256_storeu_ps(data + i, _mm256_min_ps(value, limit_lanes));
+	}
+#elif defined(XTR_SIMD_SSE2)
+	const auto exponent = _mm_set1_epi32(0x3F800000);
+	const auto one = _mm_set1_ps(1.0f);
+	const auto low_lanes = _mm_set1_ps(low);
+	const auto scale_lanes = _mm_set1_ps(scale);
+	const auto limit_lanes = _mm_set1_ps(limit);
+	for (; i + 4 <= count; i += 4) {
+		const auto pattern = _mm_or_si128(
+		    _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bits + i)), 9),
+		    exponent);
+		const auto unit = _mm_sub_ps(_mm_castsi128_ps(pattern), one);
+		const auto value = _mm_add_ps(low_lanes, _mm_mul_ps(scale_lanes, unit));
+		_mm_storeu_ps(data + i, _mm_min_ps(value, limit_lanes));
+	}
+#endif
+	for (; i < count; ++i) {
+		data[i] = ::std::min(low + scale * random_unit_float(bits[i]), limit);
+	}
+}
+
+// Uniform in (0, 1), for logarithms
+XTR_NODISCARD inline double random_open_unit(::std::uint64_t bits) noexcept {
+	return (static_cast<double>(bits >> 11) + 0.5) * 0x1.0p-53;
+}
+
+// Ziggurat of 128 layers from Doornik's ZIGNOR, layer 0 is the base with the tail
+struct normal_ziggurat {
+	static constexpr int layers = 128;
+	static constexpr double tail = 3.442619855899;
+	static constexpr double area = 9.91256303526217e-3;
+
+	// Right edge of each layer
+	double m_edge[layers + 1];
+	// Ratio of the edge of the layer above to the edge of each layer, below which a point lies
+	// in the rectangle inside the curve
+	double m_inner[layers];
+};
+
+// Built on first use, constant evaluation would cost every translation unit
+inline const normal_ziggurat &normal_table() {
+	static normal_ziggurat table;
+	static const bool built = [] {
+		auto height = ::std::exp(-0.5 * normal_ziggurat::tail * normal_ziggurat::tail);
+		table.m_edge[0] = normal_ziggurat::area / height;
+		table.m_edge[1] = normal_ziggurat::tail;
+		table.m_edge[normal_ziggurat::layers] = 0;
+		for (int i = 2; i < normal_ziggurat::layers; ++i) {
+			table.m_edge[i] =
+			    ::std::sqrt(-2 * ::std::log(normal_ziggurat::area / table.m_edge[i - 1] + height));
+			height = ::std::exp(-0.5 * table.m_edge[i] * table.m_edge[i]);
+		}
+		for (int i = 0; i < normal_ziggurat::layers; ++i) {
+			table.m_inner[i] = table.m_edge[i + 1] / table.m_edge[i];
+		}
+		return true;
+	}();
+	static_cast<void>(built);
+	return table;
+}
+
+// Standard normal from one draw, nearly always without drawing more
+template <typename Generator>
+XTR_NODISCARD double random_normal(Generator &generator, ::std::uint64_t bits,
+                                   const normal_ziggurat &table) {
+	for (;;) {
+		// The layer comes from the low bits and the position from the high bits
+		const auto layer = static_cast<int>(bits & (normal_ziggurat::layers - 1));
+		const auto position = 2 * random_unit(bits) - 1;
+		if (::std::abs(position) < table.m_inner[layer]) {
+			return position * table.m_edge[layer];
+		}
+		if (layer == 0) {
+			double x;
+			double y;
+			do {
+				x = ::std::log(random_open_unit(generator())) / normal_ziggurat::tail;
+				y = ::std::log(random_open_unit(generator()));
+			} while (-2 * y < x * x);
+			return position < 0 ? x - normal_ziggurat::tail : normal_ziggurat::tail - x;
+		}
+		const auto x = position * table.m_edge[layer];
+		const auto outer = ::std::exp(-0.5 * (table.m_edge[layer] * table.m_edge[layer] - x * x));
+		const auto inner =
+		    ::std::exp(-0.5 * (table.m_edge[layer + 1] * table.m_edge[layer + 1] - x * x));
+		if (inner + random_unit(generator()) * (outer - inner) < 1.0) {
+			return x;
+		}
+		bits = generator();
+	}
+}
+
+XTR_NODISCARD inline ::std::uint64_t multiply_high(::std::uint64_t left, ::std::uint64_t right,
+                                                   ::std::uint64_t &low) noexcept {
+#if defined(XTR_COMPILER_GNUC) && defined(__SIZEOF_INT128__)
+	__extension__ using wide = unsigned __int128;
+	const auto product = static_cast<wide>(left) * right;
+	low = static_cast<::std::uint64_t>(product);
+	return static_cast<::std::uint64_t>(product >> 64);
+#else
+	const auto left_low = left & 0xFFFFFFFFu;
+	const auto left_high = left >> 32;
+	const auto right_low = right & 0xFFFFFFFFu;
+	const auto right_high = right >> 32;
+	const auto cross = (left_low * right_low >> 32) + (left_high * right_low & 0xFFFFFFFFu)
+	                   + left_low * right_high;
+	low = left * right;
+	return left_high * right_high + (left_high * right_low >> 32) + (cross >> 32);
+#endif
+}
+
+// Lemire's multiply and reject method, which only divides in the rare case that the low half of
+// the product falls below the range
+template <typename Draw>
+XTR_NODISCARD ::std::uint32_t random_below(::std::uint32_t bits, ::std::uint32_t range,
+                                           Draw &&draw) {
+	auto product = ::std::uint64_t{bits} * range;
+	auto low = static_cast<::std::uint32_t>(product);
+	if (low < range) {
+		const auto threshold = (0u - range) % range;
+		while (low < threshold) {
+			product = ::std::uint64_t{draw()} * range;
+			low = static_cast<::std::uint32_t>(product);
+		}
+	}
+	return static_cast<::std::uint32_t>(product >> 32);
+}
+
+template <typename Draw>
+XTR_NODISCARD ::std::uint64_t random_below(::std::uint64_t bits, ::std::uint64_t range,
+                                           Draw &&draw) {
+	::std::uint64_t low;
+	auto high = multiply_high(bits, range, low);
+	if (low < range) {
+		const auto threshold = (0 - range) % range;
+		while (low < threshold) {
+			high = multiply_high(draw(), range, low);
+		}
+	}
+	return high;
+}
+
+} // namespace detail
+
+
+// Fills count values uniformly distributed in [low, high). Doubles have 52 random bits and floats
+// have 23, the bits are made with one integer operation so the loop vectorizes
+template <typename Generator, typename Real>
+void generate_uniform(Generator &generator, Real *data, ::std::size_t count,
+                      detail::random_value_t<Real> low = 0, detail::random_value_t<Real> high = 1) {
+	static_assert(::std::is_floating_point_v<Real>, "Type must be floating point");
+	assert(low <= high);
+	::std::uint64_t bits[detail::random_chunk];
+	const auto scale = high - low;
+	const auto limit = ::std::nextafter(high, low);
+	while (count > 0) {
+		if constexpr (::std::is_same_v<Real, float>) {
+			const auto size = ::std::min(count, detail::random_chunk * 2);
+			detail::random_fill(generator, bits, (size + 1) / 2);
+			::std::uint32_t halves[detail::random_chunk * 2];
+			::std::memcpy(halves, bits, (size + 1) / 2 * sizeof(bits[0]));
+			detail::random_uniform_values(halves, data, size, low, scale, limit);
+			data += size;
+			count -= size;
+		}
+		else {
+			const auto size = ::std::min(count, detail::random_chunk);
+			detail::random_fill(generator, bits, size);
+			if constexpr (::std::is_same_v<Real, double>) {
+				detail::random_uniform_values(bits, data, size, low, scale, limit);
+			}
+			else {
+				for (::std::size_t i = 0; i < size; ++i) {
+					data[i] = ::std::min(
+					    static_cast<Real>(low + scale * detail::random_unit(bits[i])), limit);
+				}
+			}
+			data += size;
+			count -= size;
+		}
+	}
+}
+
+// Fills count normally distributed values with the ziggurat method, which takes one draw and a
+// table lookup for almost all values
+template <typename Generator, typename Real>
+void generate_normal(Generator &generator, Real *data, ::std::size_t count,
+                     detail::random_value_t<Real> mean = 0,
+                     detail::random_value_t<Real> deviation = 1) {
+	static_assert(::std::is_floating_point_v<Real>, "Type must be floating point");
+	const auto &table = detail::normal_table();
+	::std::uint64_t bits[detail::random_chunk];
+	while (count > 0) {
+		const auto size = ::std::min(count, detail::random_chunk);
+		detail::random_fill(generator, bits, size);
+		for (::std::size_t i = 0; i < size; ++i) {
+			// The common case of a point inside the rectangle of its layer is kept inline
+			const auto layer = bits[i] & (detail::normal_ziggurat::layers - 1);
+			const auto position = 2 * detail::random_unit(bits[i]) - 1;
+			const auto value = ::std::abs(position) < table.m_inner[layer]
+			                       ? position * table.m_edge[layer]
+			                       : detail::random_normal(generator, bits[i], table);
+			data[i] = static_cast<Real>(mean + deviation * value);
+		}
+		data += size;
+		count -= size;
+	}
+}
+
+// Fills count integers uniformly distributed in [low, high] without bias. Types up to 32 bits
+// take two values from each draw
+template <typename Generator, typename Integer>
+void generate_bounded(Generator &generator, Integer *data, ::std::size_t count,
+                      detail::random_value_t<Integer> low, detail::random_value_t<Integer> high) {
+	static_assert(::std::is_integral_v<Integer> && !::std::is_same_v<Integer, bool>,
+	              "Type must be an integer");
+	assert(low <= high);
+	using unsigned_type = ::std::make_unsigned_t<Integer>;
+	::std::uint64_t bits[detail::random_chunk];
+	const auto offset = static_cast<unsigned_type>(low);
+	while (count > 0) {
+		if constexpr (sizeof(Integer) <= 4) {
+			const auto range = static_cast<::std::uint32_t>(
+			    static_cast<unsigned_type>(static_cast<unsigned_type>(high) - offset) + 1u);
+			const auto size = ::std::min(count, detail::random_chunk * 2);
+			detail::random_fill(generator, bits, (size + 1) / 2);
+			::std::uint32_t halves[detail::random_chunk * 2];
+			::std::memcpy(halves, bits, (size + 1) / 2 * sizeof(bits[0]));
+			const auto draw = [&] { return static_cast<::std::uint32_t>(generator() >> 32); };
+			for (::std::size_t i = 0; i < size; ++i) {
+				const auto value =
+				    range == 0 ? halves[i] : detail::random_below(halves[i], range, draw);
+				data[i] = static_cast<Integer>(static_cast<unsigned_type>(offset + value));
+			}
+			data += size;
+			count -= size;
+		}
+		else {
+			const auto range =
+			    static_cast<::std::uint64_t>(static_cast<unsigned_type>(high) - offset) + 1;
+			const auto size = ::std::min(count, detail::random_chunk);
+			detail::random_fill(generator, bits, size);
+			const auto draw = [&] { return static_cast<::std::uint64_t>(generator()); };
+			for (::std::size_t i = 0; i < size; ++i) {
+				const auto value =
+				    range == 0 ? bits[i] : detail::random_below(bits[i], range, draw);
+				data[i] = static_cast<Integer>(static_cast<unsigned_type>(offset + value));
+			}
+			data += size;
+			count -= size;
+		}
+	}
+}
+
+
+// Fill contiguous ranges, including nested ones such as multiarray and multiarray_vector
+template <typename Generator, typename Range>
+void generate_uniform(Generator &generator, Range &&range, detail::random_value_t<Range> low = 0,
+                      detail::random_value_t<Range> high = 1) {
+	auto fill_row = [&](auto *data, ::std::size_t count) {
+		generate_uniform(generator, data, count, low, high);
+	};
+	detail::random_for_each_row(range, fill_row);
+}
+
+template <typename Generator, typename Range>
+void generate_normal(Generator &generator, Range &&range, detail::random_value_t<Range> mean = 0,
+                     detail::random_value_t<Range> deviation = 1) {
+	auto fill_row = [&](auto *data, ::std::size_t count) {
+		generate_normal(generator, data, count, mean, deviation);
+	};
+	detail::random_for_each_row(range, fill_row);
+}
+
+template <typename Generator, typename Range>
+void generate_bounded(Generator &generator, Range &&range, detail::random_value_t<Range> low,
+                      detail::random_value_t<Range> high) {
+	auto fill_row = [&](auto *data, ::std::size_t count) {
+		generate_bounded(generator, data, count, low, high);
+	};
+	detail::random_for_each_row(range, fill_row);
+}
+
+} // namespace xtr
+
+#endif // XTR_RANDOM
+
+
 #endif // EXTRA_H